@@ -0,0 +1,307 @@
+//
+// Transformée en tout ou rien par table de voisinage, amincissement et
+// squelette d'images binaires.
+//
+
+#include "outils.h"
+#include "instrumentation.h"
+#include "parallele.h"
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+/*
+ * Le voisinage 3x3 d'un pixel est codé sur 9 bits : le bit 3 (dx + 1) + (dy + 1)
+ * vaut 1 si le pixel décalé de (dx, dy) appartient à l'objet (BLACK), 0 s'il
+ * est du fond ou hors de l'image. Une paire d'éléments de la transformée en
+ * tout ou rien devient deux masques (cellules qui doivent toucher l'objet,
+ * cellules qui doivent le manquer), et l'ensemble des voisinages qu'elle
+ * reconnaît une table de 512 entrées : le test d'un pixel se réduit à une
+ * lecture, quel que soit le nombre de cellules de la paire.
+ */
+
+typedef std::array<bool, 512> t_TableVoisinage;
+
+// cellules imposées d'une paire : sur l'objet (touche), sur le fond (manque)
+typedef struct {
+    unsigned int touche, manque;
+} t_Masques;
+
+static unsigned int bitVoisin(const int dx, const int dy) {
+    return 1u << (3 * (dx + 1) + (dy + 1));
+}
+
+// cellules actives (BLACK) d'un élément 3x3 centré
+static unsigned int masqueElement(const t_ElementStructurant *element) {
+    assert(element->w == 3 && element->h == 3 && "L'élément doit être de taille 3x3.");
+    assert(element->centreX == 1 && element->centreY == 1 && "L'élément doit être centré.");
+    unsigned int masque = 0;
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            if (element->valeurs[i][j] == BLACK)
+                masque |= bitVoisin(j - 1, i - 1);
+    return masque;
+}
+
+/*
+ * Paire décrite par ses trois lignes « 000/.1./111 » : 1 pour une cellule sur
+ * l'objet, 0 pour une cellule sur le fond, . pour une cellule indifférente.
+ */
+static t_Masques masquesMotif(const char *motif) {
+    t_Masques m = {0, 0};
+    for (int i = 0, k = 0; i < 3; i++, k++)
+        for (int j = 0; j < 3; j++, k++) {
+            if (motif[k] == '1')
+                m.touche |= bitVoisin(j - 1, i - 1);
+            else if (motif[k] == '0')
+                m.manque |= bitVoisin(j - 1, i - 1);
+        }
+    return m;
+}
+
+// rotation d'un quart de tour : la cellule (dx, dy) passe en (-dy, dx)
+static unsigned int tournerMasque(const unsigned int masque) {
+    unsigned int tourne = 0;
+    for (int dy = -1; dy <= 1; dy++)
+        for (int dx = -1; dx <= 1; dx++)
+            if (masque & bitVoisin(dx, dy))
+                tourne |= bitVoisin(-dy, dx);
+    return tourne;
+}
+
+static t_TableVoisinage construireTable(const t_Masques &m) {
+    assert((m.touche & m.manque) == 0 && "Une cellule ne peut pas être à la fois sur l'objet et sur le fond.");
+    t_TableVoisinage table;
+    for (unsigned int code = 0; code < 512; code++)
+        table[code] = (code & m.touche) == m.touche && (code & m.manque) == 0;
+    return table;
+}
+
+// la paire et ses trois rotations d'un quart de tour, dans cet ordre
+static void ajouterRotations(std::vector<t_TableVoisinage> &tables, t_Masques m) {
+    for (int r = 0; r < 4; r++) {
+        tables.push_back(construireTable(m));
+        m.touche = tournerMasque(m.touche);
+        m.manque = tournerMasque(m.manque);
+    }
+}
+
+/**
+ * @brief Transformée en tout ou rien : un pixel est retenu si les cellules
+ *        actives de @p touche recouvrent toutes des pixels de l'objet (BLACK)
+ *        et celles de @p manque toutes des pixels du fond.
+ *
+ * Les pixels hors de l'image comptent comme du fond. Pour chaque ligne, les
+ * trois pixels de chaque colonne sont codés une fois, puis le code de chaque
+ * voisinage est assemblé à partir de trois colonnes et lu dans la table.
+ *
+ * @param imgIn   Image binaire d'entrée (objet à 0, tout autre niveau est du fond).
+ * @param imgOut  Reçoit BLACK pour les pixels retenus, WHITE pour les autres.
+ * @param touche  Élément 3x3 centré : cellules qui doivent être sur l'objet.
+ * @param manque  Élément 3x3 centré : cellules qui doivent être sur le fond.
+ *
+ * @pre imgIn != imgOut, de mêmes dimensions
+ * @pre touche et manque sont des éléments 3x3 centrés sans cellule active commune
+ */
+void toutOuRien(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *touche,
+                const t_ElementStructurant *manque) {
+    INSTRUMENTER("toutOuRien");
+    COMPTER_PIXELS((size_t) imgIn->w * imgIn->h);
+    COMPTER_LECTURE((size_t) imgIn->w * imgIn->h);
+    assert(imgIn != imgOut && "L'image de sortie doit être distincte de l'image d'entrée.");
+    assert(imgOut->w == imgIn->w && "La largeur de l'image d'entrée et de sortie doivent être égale.");
+    assert(imgOut->h == imgIn->h && "La hauteur de l'image d'entrée et de sortie doivent être égale.");
+
+    const t_TableVoisinage table = construireTable({masqueElement(touche), masqueElement(manque)});
+    t_Pixel resultat[512];
+    for (int c = 0; c < 512; c++)
+        resultat[c] = table[c] ? BLACK : WHITE;
+
+    const int w = imgIn->w, h = imgIn->h;
+    const std::vector<t_Pixel> fond(w, WHITE);
+    pourBandes(h, 1, 1, [&](const t_Bande &b) {
+        // colonnes[x + 1] : bits des pixels (x, y - 1), (x, y) et (x, y + 1)
+        std::vector<uint16_t> colonnes(w + 2, 0);
+        for (int y = b.y0; y < b.y1; y++) {
+            const t_Pixel *haut = y > 0 ? imgIn->ligne(y - 1) : fond.data();
+            const t_Pixel *milieu = imgIn->ligne(y);
+            const t_Pixel *bas = y + 1 < h ? imgIn->ligne(y + 1) : fond.data();
+            for (int x = 0; x < w; x++)
+                colonnes[x + 1] = (uint16_t) ((haut[x] == BLACK) | (milieu[x] == BLACK) << 1 | (bas[x] == BLACK) << 2);
+            t_Pixel *sortie = imgOut->ligne(y);
+            for (int x = 0; x < w; x++)
+                sortie[x] = resultat[colonnes[x] | colonnes[x + 1] << 3 | colonnes[x + 2] << 6];
+        }
+    });
+}
+
+/*
+ * Amincissement par une suite de tables : à chaque étape, les pixels de l'objet
+ * reconnus par la table de l'étape sont retirés tous ensemble, et la suite est
+ * reprise jusqu'à ce qu'aucune table ne retire plus rien.
+ *
+ * Seuls les pixels dont le voisinage est reconnu par l'une des tables sont
+ * testés : ils sont rangés dans une file. Un pixel dont le voisinage n'est
+ * reconnu par aucune table ne peut pas être effacé tant que ce voisinage ne
+ * change pas ; il quitte la file et n'y revient que lorsqu'un de ses voisins
+ * est effacé. Le coût après le premier parcours dépend ainsi du nombre de
+ * pixels effacés et de la longueur des bords, non du nombre d'étapes multiplié
+ * par la surface de l'image.
+ *
+ * L'objet est recopié dans un plan d'un octet par pixel bordé d'une colonne et
+ * d'une ligne de fond, pour lire les voisinages sans test de bord ; le même
+ * octet marque les pixels présents dans la file.
+ */
+static uint64_t amincirSuite(const t_Image *imgIn, t_Image *imgOut, const std::vector<t_TableVoisinage> &tables,
+                             const int iterationsMax) {
+    assert(imgOut->w == imgIn->w && "La largeur de l'image d'entrée et de sortie doivent être égale.");
+    assert(imgOut->h == imgIn->h && "La hauteur de l'image d'entrée et de sortie doivent être égale.");
+    const int w = imgIn->w, h = imgIn->h;
+    const int pas = w + 2;
+    // bit 0 : pixel de l'objet ; bit 1 : pixel dans la file
+    const uint8_t OBJET = 1, EN_FILE = 2;
+    std::vector<uint8_t> objet((size_t) pas * (h + 2), 0);
+    pourBandes(h, 0, 0, [&](const t_Bande &b) {
+        for (int y = b.y0; y < b.y1; y++) {
+            const t_Pixel *ligne = imgIn->ligne(y);
+            uint8_t *plan = objet.data() + (size_t) (y + 1) * pas + 1;
+            for (int x = 0; x < w; x++)
+                plan[x] = ligne[x] == BLACK;
+        }
+    });
+
+    const ptrdiff_t voisins[8] = {-pas - 1, -pas, -pas + 1, -1, 1, pas - 1, pas, pas + 1};
+    auto code = [&](const size_t p) {
+        const uint8_t *o = objet.data() + p;
+        return (unsigned int) ((o[-pas - 1] & OBJET) | (o[-1] & OBJET) << 1 | (o[pas - 1] & OBJET) << 2 |
+                               (o[-pas] & OBJET) << 3 | (o[0] & OBJET) << 4 | (o[pas] & OBJET) << 5 |
+                               (o[-pas + 1] & OBJET) << 6 | (o[1] & OBJET) << 7 | (o[pas + 1] & OBJET) << 8);
+    };
+
+    // voisinages reconnus par au moins une table de la suite
+    const int nombreTables = (int) tables.size();
+    t_TableVoisinage reconnu;
+    reconnu.fill(false);
+    for (const auto &table: tables)
+        for (int c = 0; c < 512; c++)
+            reconnu[c] = reconnu[c] || table[c];
+
+    std::vector<size_t> file, suivante, effaces;
+    for (int y = 0; y < h; y++)
+        for (size_t p = (size_t) (y + 1) * pas + 1, fin = p + w; p < fin; p++)
+            if (objet[p] && reconnu[code(p)]) {
+                objet[p] |= EN_FILE;
+                file.push_back(p);
+            }
+
+    uint64_t retires = 0;
+    for (int etape = 0; !file.empty() && (iterationsMax <= 0 || etape < iterationsMax * nombreTables); etape++) {
+        const t_TableVoisinage &table = tables[etape % nombreTables];
+        // tests sur l'état avant l'étape, puis effacement
+        suivante.clear();
+        effaces.clear();
+        for (const size_t p: file) {
+            const unsigned int c = code(p);
+            if (table[c])
+                effaces.push_back(p);
+            else if (reconnu[c])
+                suivante.push_back(p);
+            else
+                objet[p] = OBJET;
+        }
+        for (const size_t p: effaces)
+            objet[p] = 0;
+        // l'effacement change le voisinage des pixels autour
+        for (const size_t p: effaces)
+            for (const ptrdiff_t v: voisins) {
+                const size_t q = p + v;
+                if (objet[q] == OBJET) {
+                    objet[q] |= EN_FILE;
+                    suivante.push_back(q);
+                }
+            }
+        retires += effaces.size();
+        file.swap(suivante);
+    }
+
+    pourBandes(h, 0, 0, [&](const t_Bande &b) {
+        for (int y = b.y0; y < b.y1; y++) {
+            const uint8_t *plan = objet.data() + (size_t) (y + 1) * pas + 1;
+            t_Pixel *ligne = imgOut->ligne(y);
+            for (int x = 0; x < w; x++)
+                ligne[x] = plan[x] ? BLACK : WHITE;
+        }
+    });
+    return retires;
+}
+
+/**
+ * @brief Amincissement d'une image binaire par une paire d'éléments et ses
+ *        rotations d'un quart de tour.
+ *
+ * Une itération retire de l'objet les pixels reconnus par la transformée en
+ * tout ou rien de la paire (voir toutOuRien()), puis de chacune de ses trois
+ * rotations, chaque fois sur le résultat de la précédente.
+ *
+ * @param imgIn          Image binaire d'entrée (objet à 0).
+ * @param imgOut         Reçoit l'objet aminci (BLACK) sur fond WHITE ; peut valoir @p imgIn.
+ * @param touche         Élément 3x3 centré : cellules qui doivent être sur l'objet.
+ * @param manque         Élément 3x3 centré : cellules qui doivent être sur le fond.
+ * @param iterationsMax  Nombre d'itérations ; 0 pour continuer jusqu'à ce que
+ *                       l'image ne change plus.
+ *
+ * @return Nombre de pixels retirés de l'objet.
+ *
+ * @pre imgOut a les dimensions de imgIn
+ * @pre touche et manque sont des éléments 3x3 centrés sans cellule active commune
+ */
+uint64_t amincissement(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *touche,
+                       const t_ElementStructurant *manque, const int iterationsMax) {
+    INSTRUMENTER("amincissement");
+    COMPTER_PIXELS((size_t) imgIn->w * imgIn->h);
+    COMPTER_LECTURE((size_t) imgIn->w * imgIn->h);
+    std::vector<t_TableVoisinage> tables;
+    ajouterRotations(tables, {masqueElement(touche), masqueElement(manque)});
+    return amincirSuite(imgIn, imgOut, tables, iterationsMax);
+}
+
+/**
+ * @brief Squelette d'une image binaire, obtenu par amincissements successifs
+ *        avec les éléments L de Golay jusqu'à stabilité.
+ *
+ * Chaque itération applique les huit éléments (les deux formes ci-dessous et
+ * leurs rotations d'un quart de tour, en alternance) :
+ *
+ *     0 0 0      . 0 0
+ *     . 1 .      1 1 0
+ *     1 1 1      . 1 .
+ *
+ * Les pixels effacés sont toujours simples : le squelette, d'un pixel
+ * d'épaisseur, garde la connexité (8-connexité de l'objet) et les trous de
+ * l'image.
+ *
+ * @param imgIn          Image binaire d'entrée (objet à 0).
+ * @param imgOut         Reçoit le squelette (BLACK) sur fond WHITE ; peut valoir @p imgIn.
+ * @param iterationsMax  Nombre maximal d'itérations, 0 pour aller jusqu'à stabilité.
+ *
+ * @return Nombre de pixels retirés de l'objet.
+ *
+ * @pre imgOut a les dimensions de imgIn
+ */
+uint64_t squelette(const t_Image *imgIn, t_Image *imgOut, const int iterationsMax) {
+    INSTRUMENTER("squelette");
+    COMPTER_PIXELS((size_t) imgIn->w * imgIn->h);
+    COMPTER_LECTURE((size_t) imgIn->w * imgIn->h);
+    static const std::vector<t_TableVoisinage> golay = [] {
+        std::vector<t_TableVoisinage> l, tables;
+        ajouterRotations(l, masquesMotif("000/.1./111"));
+        ajouterRotations(l, masquesMotif(".00/110/.1."));
+        for (int r = 0; r < 4; r++) {
+            tables.push_back(l[r]);
+            tables.push_back(l[4 + r]);
+        }
+        return tables;
+    }();
+    return amincirSuite(imgIn, imgOut, golay, iterationsMax);
+}
@@ -0,0 +1,461 @@
+//
+// Banc d'essai : mesure le débit de chaque opérateur sur les images de
+// tp3-images et sur des images synthétiques de 64x64 à 8192x8192, pour des
+// éléments structurants de 3x3 à 31x31.
+//
+// Chaque mesure est précédée d'une exécution d'échauffement non mesurée puis
+// répétée (au moins --repetitions fois et 0,2 s, au plus 2 s) ; on affiche la
+// médiane, l'écart type relatif et le débit en mégapixels par seconde calculé
+// sur la médiane. --json enregistre les résultats pour suivre les régressions.
+//
+// Utilisation :
+//   bench [--images dossier|-] [--tailles 64,256,...] [--elements 3,7,...]
+//         [--formes carre,croix,...] [--operations dilatation,...]
+//         [--repetitions n] [--threads n] [--json fichier] [--rapide]
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "binaire.h"
+#include "chargesauve.h"
+#include "elements.h"
+#include "image.h"
+#include "lot.h"
+#include "noyaux.h"
+#include "outils.h"
+#include "parallele.h"
+#include "reserve.h"
+
+typedef struct {
+    std::string images = "tp3-images/";
+    std::vector<int> tailles = {64, 256, 1024, 4096, 8192};
+    std::vector<int> elements = {3, 7, 15, 31};
+    std::vector<std::string> formes = {"carre", "croix", "losange", "disque"};
+    std::vector<std::string> operations;   // vide : toutes
+    int repetitions = 5;
+    int threads = 0;
+    std::string json;
+    std::string temporaire = "bench_temporaire.pgm";
+} t_Options;
+
+typedef struct {
+    std::string operation, image, forme;
+    int w, h, taille;
+    int repetitions;
+    double medianeMs, moyenneMs, ecartTypeMs, minMs;
+} t_Mesure;
+
+static const double TEMPS_MIN_S = 0.2;
+static const double TEMPS_MAX_S = 2.0;
+static const int REPETITIONS_MAX = 100;
+
+static std::vector<std::string> decouper(const std::string &liste) {
+    std::vector<std::string> mots;
+    std::stringstream flux(liste);
+    for (std::string mot; std::getline(flux, mot, ',');)
+        if (!mot.empty())
+            mots.push_back(mot);
+    return mots;
+}
+
+static bool retenue(const t_Options &options, const std::string &operation) {
+    return options.operations.empty() ||
+           std::find(options.operations.begin(), options.operations.end(), operation) != options.operations.end();
+}
+
+/**
+ * @brief Mesure @p operation : un échauffement, puis des répétitions jusqu'à
+ *        atteindre le nombre et la durée minimaux. @p preparer est appelée,
+ *        hors mesure, avant chaque exécution.
+ */
+static t_Mesure mesurer(const t_Options &options, const std::function<void()> &preparer,
+                        const std::function<void()> &operation) {
+    preparer();
+    operation();
+
+    std::vector<double> durees;
+    double total = 0;
+    while ((int) durees.size() < 2 ||
+           (((int) durees.size() < options.repetitions || total < TEMPS_MIN_S) &&
+            (int) durees.size() < REPETITIONS_MAX && total < TEMPS_MAX_S)) {
+        preparer();
+        const auto debut = std::chrono::steady_clock::now();
+        operation();
+        const double duree = std::chrono::duration<double>(std::chrono::steady_clock::now() - debut).count();
+        durees.push_back(duree * 1000);
+        total += duree;
+    }
+
+    t_Mesure mesure = {};
+    const size_t n = durees.size();
+    std::sort(durees.begin(), durees.end());
+    mesure.repetitions = (int) n;
+    mesure.medianeMs = n % 2 ? durees[n / 2] : (durees[n / 2 - 1] + durees[n / 2]) / 2;
+    mesure.minMs = durees[0];
+    for (const double d: durees)
+        mesure.moyenneMs += d / n;
+    for (const double d: durees)
+        mesure.ecartTypeMs += (d - mesure.moyenneMs) * (d - mesure.moyenneMs) / (n - 1);
+    mesure.ecartTypeMs = std::sqrt(mesure.ecartTypeMs);
+    return mesure;
+}
+
+// loadPgm et savePgm annoncent chaque chargement et sauvegarde : leurs messages
+// sont écartés pendant les mesures
+struct t_FluxMuet : std::streambuf {
+    int overflow(const int c) override { return c; }
+};
+
+static void sansMessages(const std::function<void()> &operation) {
+    static t_FluxMuet muet;
+    std::streambuf *ancien = std::cout.rdbuf(&muet);
+    operation();
+    std::cout.rdbuf(ancien);
+}
+
+static double megapixelsParSeconde(const t_Mesure &m) {
+    return (double) m.w * m.h / 1e6 / (m.medianeMs / 1000);
+}
+
+static void afficher(const t_Mesure &m) {
+    char texte[256];
+    const std::string element = m.taille > 0 ? m.forme + " " + std::to_string(m.taille) : "";
+    snprintf(texte, sizeof texte, "%-12s %-28s %5dx%-5d %-12s %10.3f ms  ±%5.1f %%  %9.1f Mpx/s  (%d)",
+             m.operation.c_str(), m.image.c_str(), m.w, m.h, element.c_str(), m.medianeMs,
+             m.moyenneMs > 0 ? 100 * m.ecartTypeMs / m.moyenneMs : 0.0, megapixelsParSeconde(m), m.repetitions);
+    std::cout << texte << std::endl;
+}
+
+static void copier(const t_Image *source, t_Image *copie) {
+    copie->allouer(source->h, source->w);
+    for (int y = 0; y < source->h; y++)
+        memcpy(copie->ligne(y), source->ligne(y), source->w);
+}
+
+/**
+ * @brief Somme des pixels de @p image : lit chaque ligne, pour que les pages
+ *        d'une image projetée en mémoire soient effectivement chargées.
+ */
+static uint64_t sommer(const t_Image *image) {
+    uint64_t somme = 0;
+    for (int y = 0; y < image->h; y++) {
+        const t_Pixel *ligne = image->ligne(y);
+        for (int x = 0; x < image->w; x++)
+            somme += ligne[x];
+    }
+    return somme;
+}
+
+static void remplir(t_Image *image, const t_Pixel couleur) {
+    for (int y = 0; y < image->h; y++)
+        memset(image->ligne(y), couleur, image->w);
+}
+
+/**
+ * @brief Image synthétique de côté @p cote : taches de tailles variées sur un
+ *        fond bruité, pour que les opérateurs morphologiques aient des bords à
+ *        traiter à toutes les échelles.
+ */
+static t_Image *imageSynthetique(const int cote) {
+    t_Image *image = createImage(cote, cote);
+    unsigned int graine = 12345;
+    for (int y = 0; y < cote; y++) {
+        t_Pixel *ligne = image->ligne(y);
+        for (int x = 0; x < cote; x++) {
+            graine = graine * 1103515245u + 12345u;
+            const double onde = std::sin(x * 0.05) * std::cos(y * 0.07) + std::sin((x + y) * 0.013);
+            ligne[x] = (t_Pixel) std::min(255.0, std::max(0.0, 128 + 70 * onde + (int) ((graine >> 16) % 64) - 32));
+        }
+    }
+    return image;
+}
+
+/**
+ * @brief Mesure tous les opérateurs retenus sur une image en niveaux de gris.
+ */
+static void mesurerImage(const t_Options &options, const std::string &nom, t_Image *gris,
+                         std::vector<t_Mesure> &mesures) {
+    auto enregistrer = [&](t_Mesure m, const std::string &operation, const std::string &forme, const int taille) {
+        m.operation = operation;
+        m.image = nom;
+        m.forme = forme;
+        m.taille = taille;
+        m.w = gris->w;
+        m.h = gris->h;
+        afficher(m);
+        mesures.push_back(m);
+    };
+    const auto rien = [] {};
+
+    // entrées et sorties
+    for (const t_FormatPgm format: {PGM_ASCII, PGM_BINAIRE}) {
+        const std::string suffixe = format == PGM_ASCII ? "_p2" : "_p5";
+        sansMessages([&] { savePgm(options.temporaire, gris, format); });
+        if (retenue(options, "savePgm")) {
+            t_Mesure m;
+            sansMessages([&] { m = mesurer(options, rien, [&] { savePgm(options.temporaire, gris, format); }); });
+            enregistrer(m, "savePgm" + suffixe, "", 0);
+        }
+        if (retenue(options, "loadPgm")) {
+            t_Image chargee;
+            bool ok;
+            t_Mesure m;
+            volatile uint64_t somme = 0;
+            // loadPgm ne fait que projeter un fichier P5 : la somme lit les pixels dans la mesure
+            sansMessages([&] {
+                m = mesurer(options, rien, [&] {
+                    loadPgm(options.temporaire, &chargee, ok);
+                    somme = sommer(&chargee);
+                });
+            });
+            enregistrer(m, "loadPgm" + suffixe, "", 0);
+        }
+        if (retenue(options, "loadPgmSeuil")) {
+            t_Image chargee;
+            t_ImageBinaire compactee;
+            bool ok;
+            t_Mesure m;
+            sansMessages([&] { m = mesurer(options, rien, [&] { loadPgmSeuil(options.temporaire, 128, &chargee, ok); }); });
+            enregistrer(m, "loadPgmSeuil" + suffixe, "", 0);
+            sansMessages([&] {
+                m = mesurer(options, rien, [&] { loadPgmSeuil(options.temporaire, 128, &compactee, ok); });
+            });
+            enregistrer(m, "loadPgmSeuilBinaire" + suffixe, "", 0);
+        }
+    }
+    remove(options.temporaire.c_str());
+
+    t_Image binaire, copie, sortie;
+    copier(gris, &binaire);
+    seuillage(&binaire, 128);
+    sortie.allouer(gris->h, gris->w);
+
+    if (retenue(options, "seuillage"))
+        enregistrer(mesurer(options, [&] { copier(gris, &copie); }, [&] { seuillage(&copie, 128); }),
+                    "seuillage", "", 0);
+    if (retenue(options, "histogramme")) {
+        uint64_t histo[256];
+        enregistrer(mesurer(options, rien, [&] { histogramme(gris, histo); }), "histogramme", "", 0);
+    }
+    if (retenue(options, "otsu"))
+        enregistrer(mesurer(options, [&] { copier(gris, &copie); }, [&] { seuillageAutomatique(&copie); }),
+                    "otsu", "", 0);
+    if (retenue(options, "difference"))
+        enregistrer(mesurer(options, rien, [&] { difference(gris, &binaire, &sortie); }), "difference", "", 0);
+    if (retenue(options, "bilanDifference")) {
+        t_BilanDifference bilan;
+        enregistrer(mesurer(options, rien, [&] { difference(gris, &binaire, nullptr, &bilan, 16); }),
+                    "bilanDifference", "", 0);
+    }
+    if (retenue(options, "toutOuRien")) {
+        // premier élément L de Golay : ligne du haut sur le fond, centre et ligne du bas sur l'objet
+        t_ElementStructurant *touche = createElement(3, 3, 1, 1, WHITE), *manque = createElement(3, 3, 1, 1, WHITE);
+        for (int j = 0; j < 3; j++) {
+            manque->valeurs[0][j] = BLACK;
+            touche->valeurs[2][j] = BLACK;
+        }
+        touche->valeurs[1][1] = BLACK;
+        enregistrer(mesurer(options, rien, [&] { toutOuRien(&binaire, &sortie, touche, manque); }), "toutOuRien", "", 0);
+        delete touche;
+        delete manque;
+    }
+    if (retenue(options, "squelette"))
+        enregistrer(mesurer(options, rien, [&] { squelette(&binaire, &sortie); }), "squelette", "", 0);
+    if (retenue(options, "etiquetage")) {
+        t_Etiquettes etiquettes;
+        std::vector<t_Composante> composantes;
+        enregistrer(mesurer(options, rien, [&] { etiqueter(&binaire, &etiquettes, &composantes, CONNEXITE_8); }),
+                    "etiquetage8", "", 0);
+        enregistrer(mesurer(options, rien, [&] { etiqueter(&binaire, &etiquettes, &composantes, CONNEXITE_4); }),
+                    "etiquetage4", "", 0);
+    }
+    if (retenue(options, "reconstruction")) {
+        // marqueurs : l'objet de la moitié gauche de l'image binaire ; l'image
+        // en niveaux de gris éclaircie de 32 (les creux de moins de 32 niveaux s'effacent)
+        t_Image marqueur;
+        copier(&binaire, &marqueur);
+        for (int y = 0; y < marqueur.h; y++)
+            std::fill(marqueur.ligne(y) + marqueur.w / 2, marqueur.ligne(y) + marqueur.w, (t_Pixel) WHITE);
+        enregistrer(mesurer(options, rien, [&] { reconstructionDilatation(&marqueur, &binaire, &sortie); }),
+                    "reconstruction", "", 0);
+        copier(gris, &marqueur);
+        for (int y = 0; y < marqueur.h; y++)
+            for (int x = 0; x < marqueur.w; x++)
+                marqueur.ligne(y)[x] = (t_Pixel) std::min(255, marqueur.ligne(y)[x] + 32);
+        enregistrer(mesurer(options, rien, [&] { reconstructionDilatation(&marqueur, gris, &sortie); }),
+                    "reconstructionGris", "", 0);
+    }
+    if (retenue(options, "remplirTrous")) {
+        enregistrer(mesurer(options, rien, [&] { remplirTrous(&binaire, &sortie); }), "remplirTrous", "", 0);
+        enregistrer(mesurer(options, rien, [&] { remplirTrous(gris, &sortie); }), "remplirTrousGris", "", 0);
+    }
+    if (retenue(options, "supprimerBord"))
+        enregistrer(mesurer(options, rien, [&] { supprimerBord(&binaire, &sortie); }), "supprimerBord", "", 0);
+
+    typedef void (*t_Operateur)(const t_Image *, t_Image *, const t_ElementStructurant *, unsigned int);
+    const std::pair<const char *, t_Operateur> morphologie[] = {
+            {"dilatation", dilatation}, {"erosion", erosion}, {"ouverture", ouverture}, {"fermeture", fermeture}};
+    // opérateurs en une passe (gradients.cpp), qui écrivent toute la sortie
+    typedef void (*t_OperateurContour)(const t_Image *, t_Image *, const t_ElementStructurant *);
+    const std::pair<const char *, t_OperateurContour> contours[] = {
+            {"gradientInterne", [](const t_Image *in, t_Image *out, const t_ElementStructurant *e) {
+                gradient(in, out, e, GRADIENT_INTERNE);
+            }},
+            {"gradientExterne", [](const t_Image *in, t_Image *out, const t_ElementStructurant *e) {
+                gradient(in, out, e, GRADIENT_EXTERNE);
+            }},
+            {"gradient", [](const t_Image *in, t_Image *out, const t_ElementStructurant *e) {
+                gradient(in, out, e, GRADIENT_SYMETRIQUE);
+            }},
+            {"contour", contour}, {"chapeauBlanc", chapeauBlanc}, {"chapeauNoir", chapeauNoir}};
+    for (const auto &forme: options.formes)
+        for (const int taille: options.elements) {
+            t_ElementStructurant *element = elementForme(forme, taille / 2);
+            for (const auto &operateur: morphologie)
+                if (retenue(options, operateur.first))
+                    enregistrer(mesurer(options, [&] { remplir(&sortie, WHITE); },
+                                        [&] { operateur.second(&binaire, &sortie, element, BLACK); }),
+                                operateur.first, forme, taille);
+            for (const auto &operateur: contours)
+                if (retenue(options, operateur.first))
+                    enregistrer(mesurer(options, rien, [&] { operateur.second(&binaire, &sortie, element); }),
+                                operateur.first, forme, taille);
+            // mêmes opérateurs par les noyaux spécialisés sur la forme (elements.h),
+            // pour les rayons instanciés
+            appliquerForme(forme, taille / 2, [&](auto motif) {
+                typedef decltype(motif) t_Forme;
+                if (retenue(options, "dilatationForme"))
+                    enregistrer(mesurer(options, [&] { remplir(&sortie, WHITE); },
+                                        [&] { dilatation<t_Forme>(&binaire, &sortie, BLACK); }),
+                                "dilatationForme", forme, taille);
+                if (retenue(options, "erosionForme"))
+                    enregistrer(mesurer(options, [&] { remplir(&sortie, WHITE); },
+                                        [&] { erosion<t_Forme>(&binaire, &sortie, BLACK); }),
+                                "erosionForme", forme, taille);
+            });
+            delete element;
+        }
+    viderReserve();
+}
+
+static void ecrireJson(const t_Options &options, const std::vector<t_Mesure> &mesures) {
+    FILE *fichier = fopen(options.json.c_str(), "w");
+    if (fichier == nullptr) {
+        std::cout << options.json << ": impossible d'écrire le fichier" << std::endl;
+        return;
+    }
+    fprintf(fichier, "{\n  \"threads\": %d,\n  \"noyaux\": \"%s\",\n  \"mesures\": [\n", nombreThreads(),
+            noyaux().nom);
+    for (size_t i = 0; i < mesures.size(); i++) {
+        const t_Mesure &m = mesures[i];
+        fprintf(fichier,
+                "    {\"operation\": \"%s\", \"image\": \"%s\", \"w\": %d, \"h\": %d, \"forme\": \"%s\", "
+                "\"taille\": %d, \"repetitions\": %d, \"mediane_ms\": %.6f, \"moyenne_ms\": %.6f, "
+                "\"ecart_type_ms\": %.6f, \"min_ms\": %.6f, \"mpx_s\": %.3f}%s\n",
+                m.operation.c_str(), m.image.c_str(), m.w, m.h, m.forme.c_str(), m.taille, m.repetitions,
+                m.medianeMs, m.moyenneMs, m.ecartTypeMs, m.minMs, megapixelsParSeconde(m),
+                i + 1 < mesures.size() ? "," : "");
+    }
+    fprintf(fichier, "  ]\n}\n");
+    fclose(fichier);
+}
+
+static bool lireOptions(int argc, char *argv[], t_Options &options) {
+    for (int i = 1; i < argc; i++) {
+        const std::string option = argv[i];
+        if (option == "--rapide") {
+            options.tailles = {64, 256, 1024};
+            options.elements = {3, 7};
+            options.formes = {"carre", "disque"};
+            continue;
+        }
+        if (i + 1 >= argc)
+            return false;
+        const std::string valeur = argv[++i];
+        if (option == "--images") {
+            options.images = valeur == "-" ? "" : valeur;
+        } else if (option == "--tailles" || option == "--elements") {
+            std::vector<int> &liste = option == "--tailles" ? options.tailles : options.elements;
+            liste.clear();
+            for (const auto &mot: decouper(valeur))
+                liste.push_back(atoi(mot.c_str()));
+        } else if (option == "--formes") {
+            options.formes = decouper(valeur);
+            for (const auto &forme: options.formes)
+                if (forme != "carre" && forme != "croix" && forme != "losange" && forme != "disque")
+                    return false;
+        } else if (option == "--operations") {
+            options.operations = decouper(valeur);
+        } else if (option == "--repetitions") {
+            options.repetitions = atoi(valeur.c_str());
+        } else if (option == "--threads") {
+            options.threads = atoi(valeur.c_str());
+        } else if (option == "--json") {
+            options.json = valeur;
+        } else {
+            return false;
+        }
+    }
+    for (const int taille: options.elements)
+        if (taille < 1 || taille % 2 == 0)
+            return false;
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    t_Options options;
+    if (!lireOptions(argc, argv, options)) {
+        std::cout << "utilisation : " << argv[0]
+                  << " [--images dossier|-] [--tailles 64,256,...] [--elements 3,7,...] [--formes carre,croix,...]"
+                  << " [--operations dilatation,...] [--repetitions n] [--threads n] [--json fichier] [--rapide]"
+                  << std::endl;
+        return 1;
+    }
+    if (options.threads > 0)
+        definirNombreThreads(options.threads);
+    std::cout << "=== Banc d'essai : " << nombreThreads() << " threads, noyaux " << noyaux().nom << " ===" << std::endl;
+
+    std::vector<t_Mesure> mesures;
+    std::vector<std::string> fichiers;
+    if (!options.images.empty()) {
+        if (DIR *dossier = opendir(options.images.c_str())) {
+            while (const dirent *entree = readdir(dossier)) {
+                const std::string nom = entree->d_name;
+                if (nom.size() > 4 && nom.compare(nom.size() - 4, 4, ".pgm") == 0)
+                    fichiers.push_back(nom);
+            }
+            closedir(dossier);
+        }
+        std::sort(fichiers.begin(), fichiers.end());
+    }
+    for (const auto &fichier: fichiers) {
+        t_Image image;
+        bool ok = false;
+        const std::string chemin = options.images + "/" + fichier;
+        sansMessages([&] { loadPgm(chemin, &image, ok); });
+        if (ok)
+            mesurerImage(options, fichier, &image, mesures);
+        else
+            std::cout << chemin << " : échec du chargement" << std::endl;
+    }
+    for (const int cote: options.tailles) {
+        t_Image *image = imageSynthetique(cote);
+        mesurerImage(options, "synthetique" + std::to_string(cote), image, mesures);
+        delete image;
+    }
+
+    if (!options.json.empty())
+        ecrireJson(options, mesures);
+    return 0;
+}
@@ -0,0 +1,202 @@
+//
+// Images binaires compactées : un bit par pixel, rangés dans des mots de 64 bits.
+//
+
+#include "binaire.h"
+#include "noyaux.h"
+#include <algorithm>
+#include <cassert>
+
+/**
+ * @brief Donne à l'image binaire les dimensions @p h x @p w, tous les pixels au fond.
+ */
+void t_ImageBinaire::allouer(const int h, const int w) {
+    this->h = h;
+    this->w = w;
+    mots = (w + 63) / 64;
+    bits.assign((size_t) h * mots, 0);
+}
+
+/**
+ * @brief Masque des bits valides du dernier mot d'une ligne de largeur @p w.
+ */
+static uint64_t masqueDernierMot(const int w) {
+    const int reste = w % 64;
+    return reste == 0 ? ~uint64_t(0) : (uint64_t(1) << reste) - 1;
+}
+
+/**
+ * @brief Compacte une image seuillée : un pixel BLACK devient un bit à 1.
+ *
+ * @param image   Image d'entrée (les pixels différents de BLACK sont considérés
+ *                comme appartenant au fond).
+ * @param binaire Image binaire de sortie, redimensionnée à la taille de @p image.
+ */
+void compacter(const t_Image *image, t_ImageBinaire *binaire) {
+    binaire->allouer(image->h, image->w);
+
+    // BLACK est le seul niveau inférieur à BLACK + 1
+    const auto compacterSeuil = noyaux().compacterSeuil;
+    for (int y = 0; y < image->h; y++)
+        compacterSeuil(binaire->ligne(y), image->ligne(y), image->w, BLACK + 1);
+}
+
+/**
+ * @brief Décompacte une image binaire : un bit à 1 devient BLACK, un bit à 0 WHITE.
+ *
+ * @param binaire Image binaire d'entrée.
+ * @param image   Image de sortie, réallouée à la taille de @p binaire.
+ */
+void decompacter(const t_ImageBinaire *binaire, t_Image *image) {
+    image->allouer(binaire->h, binaire->w);
+
+    for (int y = 0; y < binaire->h; y++) {
+        const uint64_t *src = binaire->ligne(y);
+        t_Pixel *dst = image->ligne(y);
+        for (int x = 0; x < binaire->w; x++)
+            dst[x] = (src[x / 64] >> (x % 64)) & 1 ? BLACK : WHITE;
+    }
+}
+
+/**
+ * @brief Combine dans @p dst la ligne @p src décalée de @p dx pixels.
+ *
+ * Le mot k du résultat contient les pixels x = 64k .. 64k+63 de la ligne lue en
+ * x + dx. Les pixels lus hors de la ligne valent @p remplissage (0 ou tous les
+ * bits à 1). Si @p et vaut vrai la combinaison est un ET, sinon un OU.
+ */
+template<bool et>
+static void combinerLigne(uint64_t *dst, const uint64_t *src, const int mots, const int dx,
+                          const uint64_t masqueFin, const uint64_t remplissage) {
+    // division entière arrondie vers -infini
+    const int q0 = dx >= 0 ? dx / 64 : -((-dx + 63) / 64);
+    const int r = dx - q0 * 64;
+
+    auto motSource = [&](const int q) -> uint64_t {
+        if (q < 0 || q >= mots)
+            return remplissage;
+        if (q == mots - 1)
+            return src[q] | (remplissage & ~masqueFin);
+        return src[q];
+    };
+
+    for (int k = 0; k < mots; k++) {
+        const int q = k + q0;
+        uint64_t mot;
+        if (q >= 0 && q + 1 < mots - 1) {
+            // cas courant : les deux mots lus sont intérieurs à la ligne
+            mot = r == 0 ? src[q] : (src[q] >> r) | (src[q + 1] << (64 - r));
+        } else {
+            mot = motSource(q) >> r;
+            if (r != 0)
+                mot |= motSource(q + 1) << (64 - r);
+        }
+        if (et)
+            dst[k] &= mot;
+        else
+            dst[k] |= mot;
+    }
+}
+
+/**
+ * @brief Dilatation d'une image binaire compactée, 64 pixels à la fois.
+ *
+ * Un pixel de sortie appartient à la forme si au moins une cellule active de
+ * l'élément structurant, placée sur lui par son centre, recouvre un pixel de la
+ * forme. Les cellules tombant hors de l'image sont ignorées. Pour chaque cellule
+ * active, la ligne d'entrée correspondante est décalée et combinée par un OU
+ * mot à mot avec la ligne de sortie.
+ *
+ * Le résultat est celui de dilatation() appliquée à l'image décompactée avec
+ * une image de sortie initialisée à WHITE et @c fillColor = BLACK.
+ *
+ * @param imgIn   Image binaire d'entrée (non modifiée).
+ * @param imgOut  Image binaire de sortie, redimensionnée à la taille de @p imgIn.
+ * @param element Élément structurant (cellules actives à BLACK).
+ *
+ * @pre imgIn != imgOut
+ */
+void dilatation(const t_ImageBinaire *imgIn, t_ImageBinaire *imgOut, const t_ElementStructurant *element) {
+    assert(imgIn != imgOut && "L'image de sortie doit être distincte de l'image d'entrée.");
+
+    const auto decalages = decalagesActifs(element);
+    const uint64_t masqueFin = masqueDernierMot(imgIn->w);
+
+    imgOut->allouer(imgIn->h, imgIn->w);
+
+    for (int y = 0; y < imgIn->h; y++) {
+        uint64_t *dst = imgOut->ligne(y);
+        for (const auto &d: decalages) {
+            const int ySource = y + d.dy;
+            if (ySource >= 0 && ySource < imgIn->h)
+                combinerLigne<false>(dst, imgIn->ligne(ySource), imgIn->mots, d.dx, masqueFin, 0);
+        }
+        if (imgOut->mots > 0)
+            dst[imgOut->mots - 1] &= masqueFin;
+    }
+}
+
+/**
+ * @brief Érosion d'une image binaire compactée, 64 pixels à la fois.
+ *
+ * Un pixel de sortie appartient à la forme si toutes les cellules actives de
+ * l'élément structurant, placé sur lui par son centre, recouvrent des pixels de
+ * la forme. Les cellules tombant hors de l'image sont ignorées. Pour chaque
+ * cellule active, la ligne d'entrée correspondante est décalée et combinée par
+ * un ET mot à mot avec la ligne de sortie.
+ *
+ * Le résultat est celui de erosion() appliquée à l'image décompactée avec
+ * une image de sortie initialisée à WHITE et @c fillColor = BLACK.
+ *
+ * @param imgIn   Image binaire d'entrée (non modifiée).
+ * @param imgOut  Image binaire de sortie, redimensionnée à la taille de @p imgIn.
+ * @param element Élément structurant (cellules actives à BLACK).
+ *
+ * @pre imgIn != imgOut
+ */
+void erosion(const t_ImageBinaire *imgIn, t_ImageBinaire *imgOut, const t_ElementStructurant *element) {
+    assert(imgIn != imgOut && "L'image de sortie doit être distincte de l'image d'entrée.");
+
+    const auto decalages = decalagesActifs(element);
+    const uint64_t masqueFin = masqueDernierMot(imgIn->w);
+
+    imgOut->allouer(imgIn->h, imgIn->w);
+    std::fill(imgOut->bits.begin(), imgOut->bits.end(), ~uint64_t(0));
+
+    for (int y = 0; y < imgIn->h; y++) {
+        uint64_t *dst = imgOut->ligne(y);
+        for (const auto &d: decalages) {
+            const int ySource = y + d.dy;
+            if (ySource >= 0 && ySource < imgIn->h)
+                combinerLigne<true>(dst, imgIn->ligne(ySource), imgIn->mots, d.dx, masqueFin, ~uint64_t(0));
+        }
+        if (imgOut->mots > 0)
+            dst[imgOut->mots - 1] &= masqueFin;
+    }
+}
+
+/**
+ * @brief Ouverture d'une image binaire compactée : érosion puis dilatation.
+ *
+ * @note L'image intermédiaire est elle aussi compactée (w*h/8 octets).
+ */
+void ouverture(const t_ImageBinaire *imgIn, t_ImageBinaire *imgOut, const t_ElementStructurant *element) {
+    t_ImageBinaire imgEroded;
+
+    erosion(imgIn, &imgEroded, element);
+
+    dilatation(&imgEroded, imgOut, element);
+}
+
+/**
+ * @brief Fermeture d'une image binaire compactée : dilatation puis érosion.
+ *
+ * @note L'image intermédiaire est elle aussi compactée (w*h/8 octets).
+ */
+void fermeture(const t_ImageBinaire *imgIn, t_ImageBinaire *imgOut, const t_ElementStructurant *element) {
+    t_ImageBinaire imgDilated;
+
+    dilatation(imgIn, &imgDilated, element);
+
+    erosion(&imgDilated, imgOut, element);
+}
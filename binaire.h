@@ -0,0 +1,39 @@
+//
+// Images binaires compactées : un bit par pixel, rangés dans des mots de 64 bits.
+//
+
+#ifndef SMP_TP3_BINAIRE_H
+#define SMP_TP3_BINAIRE_H
+#include <cstdint>
+#include <vector>
+#include "image.h"
+#include "outils.h"
+
+/**
+ * @brief Image binaire compactée.
+ *
+ * Chaque ligne occupe @c mots mots de 64 bits ; le pixel x de la ligne y est le
+ * bit (x % 64) du mot (x / 64). Un bit à 1 représente un pixel de la forme
+ * (BLACK dans une t_Image seuillée), un bit à 0 un pixel du fond (WHITE).
+ * Les bits situés au-delà de la largeur dans le dernier mot d'une ligne sont
+ * toujours nuls.
+ */
+struct t_ImageBinaire {
+    int w = 0, h = 0;
+    int mots = 0;
+    std::vector<uint64_t> bits;
+
+    void allouer(int h, int w);
+
+    uint64_t *ligne(int i) { return bits.data() + (size_t) i * mots; }
+    const uint64_t *ligne(int i) const { return bits.data() + (size_t) i * mots; }
+};
+
+void compacter(const t_Image *image, t_ImageBinaire *binaire);
+void decompacter(const t_ImageBinaire *binaire, t_Image *image);
+
+void dilatation(const t_ImageBinaire *imgIn, t_ImageBinaire *imgOut, const t_ElementStructurant *element);
+void erosion(const t_ImageBinaire *imgIn, t_ImageBinaire *imgOut, const t_ElementStructurant *element);
+void ouverture(const t_ImageBinaire *imgIn, t_ImageBinaire *imgOut, const t_ElementStructurant *element);
+void fermeture(const t_ImageBinaire *imgIn, t_ImageBinaire *imgOut, const t_ElementStructurant *element);
+#endif //SMP_TP3_BINAIRE_H
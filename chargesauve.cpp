@@ -9,102 +9,686 @@ qui liront et écriront des fichiers PGM
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <cstring>
+#include <cstdio>
+#include <cassert>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 using namespace std;
 
 #include "image.h"
+#include "binaire.h"
 #include "chargesauve.h"
+#include "instrumentation.h"
+#include "noyaux.h"
+#include "parallele.h"
 
+//rend la projection mémoire d'un fichier (voir t_Image::adopter)
+static void libererProjection(void * bloc, size_t taille)
+{
+  munmap(bloc, taille);
+}
+
+//saute les blancs et les commentaires (de '#' jusqu'à la fin de la ligne)
+static inline void sauterBlancs(const char * & p, const char * fin)
+{
+  while (p < fin)
+    {
+      if (*p == '#')
+	{
+	  while ((p < fin) && (*p != '\n'))
+	    p = p + 1;
+	}
+      else if ((*p == ' ') || (*p == '\t') || (*p == '\n') || (*p == '\r'))
+	p = p + 1;
+      else
+	return;
+    }
+}
+
+//lit un entier positif ou nul (saturé à 999999999) ; renvoie faux
+//si aucun chiffre n'est lu
+static inline bool lireEntier(const char * & p, const char * fin, int & n)
+{
+  sauterBlancs(p, fin);
+  if ((p == fin) || (*p < '0') || (*p > '9'))
+    return false;
+  n = 0;
+  while ((p < fin) && (*p >= '0') && (*p <= '9'))
+    {
+      if (n < 100000000)
+	n = n * 10 + (*p - '0');
+      p = p + 1;
+    }
+  return true;
+}
+
+//projette le fichier NomImage en mémoire (copie privée à l'écriture)
+static bool projeterFichier(const string & NomImage, void * & Bloc, size_t & Taille)
+{
+  int Fd;
+  struct stat Infos;
+
+  INSTRUMENTER("projeterFichier");
+  Fd = open(NomImage.c_str(), O_RDONLY);
+  if (Fd < 0)
+    return false;
+  if ((fstat(Fd, &Infos) != 0) || (Infos.st_size == 0))
+    {
+      close(Fd);
+      return false;
+    }
+  Taille = (size_t) Infos.st_size;
+  COMPTER_ALLOCATION(Taille);
+  Bloc = mmap(nullptr, Taille, PROT_READ | PROT_WRITE, MAP_PRIVATE, Fd, 0);
+  close(Fd);
+  return Bloc != MAP_FAILED;
+}
+
+//entête d'un fichier PGM : type ('2' ou '5'), dimensions,
+//plus grande valeur de niveau de gris et début des pixels
+struct t_EntetePgm
+{
+  char Type;
+  int w, h, MaxGris;
+  const char * Donnees;
+};
+
+/*
+Action LireEntete(Debut, Fin, Entete, Ok)
+But : décode l'entête PGM contenue dans [Debut, Fin), commentaires
+compris. Le booléen Ok indique si l'entête est valide.
+*/
+static void lireEntete(const char * Debut, const char * Fin, t_EntetePgm & Entete, bool & Ok)
+{
+  const char * p;
+
+  INSTRUMENTER("lireEntete");
+  if ((Fin - Debut < 2) || (Debut[0] != 'P') || ((Debut[1] != '2') && (Debut[1] != '5')))
+    {
+      cout << "le fichier n'est pas au format PGM" << endl;
+      Ok = false;
+      return;
+    }
+  //le nombre magique est lu : p reste dans [Debut, Fin]
+  p = Debut + 2;
+  if (!lireEntier(p, Fin, Entete.w) || !lireEntier(p, Fin, Entete.h)
+      || (Entete.w <= 0) || (Entete.h <= 0))
+    {
+      cout << "la taille de l'image est invalide" << endl;
+      Ok = false;
+    }
+  else if (!lireEntier(p, Fin, Entete.MaxGris) || (Entete.MaxGris <= 0) || (Entete.MaxGris > 65535))
+    {
+      cout << "la plus grande valeur de niveau de gris est invalide" << endl;
+      Ok = false;
+    }
+  else if ((Debut[1] == '5') && (p >= Fin))
+    {
+      //pas même le blanc qui sépare l'entête des pixels : Donnees
+      //dépasserait Fin et la taille restante deviendrait négative
+      cout << "le fichier est tronqué" << endl;
+      Ok = false;
+    }
+  else
+    {
+      Entete.Type = Debut[1];
+      //un seul blanc sépare l'entête des pixels d'un fichier P5
+      Entete.Donnees = (Entete.Type == '5') ? p + 1 : p;
+    }
+}
+
+//ramène un niveau de gris de [0, MaxGris] dans [0, 255]
+static inline t_Pixel normaliser(unsigned int Gris, unsigned int MaxGris)
+{
+  if (Gris >= MaxGris)
+    return 255;
+  return (t_Pixel) ((Gris * 255 + MaxGris / 2) / MaxGris);
+}
+
+/*
+Action DecodeLigneAscii(p, Fin, MaxGris, w, Ligne, Ok)
+But : lit à partir de p les w niveaux de gris texte suivants d'un fichier
+P2, ramenés sur [0, 255], dans Ligne. p avance jusqu'après le dernier.
+*/
+static void decoderLigneAscii(const char * & p, const char * Fin, unsigned int MaxGris, int w,
+			      t_Pixel * Ligne, bool & Ok)
+{
+  int j,Gris;
+
+  for (j=0;j<w;j=j+1)
+    {
+      if (!lireEntier(p, Fin, Gris))
+	{
+	  cout << "le fichier est tronqué" << endl;
+	  Ok = false;
+	  return;
+	}
+      if (MaxGris == 255)
+	Ligne[j] = (Gris > 255) ? 255 : (t_Pixel) Gris;
+      else
+	Ligne[j] = normaliser((unsigned int) Gris, MaxGris);
+    }
+}
+
+/*
+Action DecodeLigneBinaire(p, MaxGris, w, Ligne)
+But : recopie à partir de p les w pixels suivants d'un fichier P5 dans
+Ligne en les ramenant sur 8 bits (deux octets, poids fort en tête, par
+pixel lorsque MaxGris dépasse 255). p avance jusqu'après le dernier.
+*/
+static void decoderLigneBinaire(const unsigned char * & p, unsigned int MaxGris, int w, t_Pixel * Ligne)
+{
+  int j;
+  const size_t Octets = (MaxGris > 255) ? 2 : 1;
+
+  for (j=0;j<w;j=j+1)
+    {
+      unsigned int Gris = p[0];
+      if (Octets == 2)
+	Gris = (Gris << 8) | p[1];
+      Ligne[j] = normaliser(Gris, MaxGris);
+      p = p + Octets;
+    }
+}
+
+/*
+Action DecodeAscii(Entete, Fin, Image, Ok)
+But : lit les niveaux de gris texte d'un fichier P2 directement depuis
+sa projection en mémoire, sans passer par un flux.
+*/
+static void decoderAscii(const t_EntetePgm & Entete, const char * Fin, t_Image * Image, bool & Ok)
+{
+  int i;
+  const char * p = Entete.Donnees;
+
+  INSTRUMENTER("decoderAscii");
+  COMPTER_PIXELS((size_t) Entete.w * Entete.h);
+  COMPTER_LECTURE(Fin - Entete.Donnees);
+  Image->allouer(Entete.h, Entete.w);
+  COMPTER_ALLOCATION((size_t) Image->h * Image->stride);
+  for (i=0;(i<Image->h) && Ok;i=i+1)
+    decoderLigneAscii(p, Fin, (unsigned int) Entete.MaxGris, Image->w, Image->ligne(i), Ok);
+}
+
+/*
+Action DecodeBinaire(Entete, Fin, Image, Ok)
+But : recopie les pixels d'un fichier P5 dont MaxGris ne vaut pas 255 en
+les ramenant sur 8 bits (deux octets, poids fort en tête, par pixel
+lorsque MaxGris dépasse 255).
+*/
+static void decoderBinaire(const t_EntetePgm & Entete, const char * Fin, t_Image * Image, bool & Ok)
+{
+  int i;
+  const unsigned char * p = (const unsigned char *) Entete.Donnees;
+  const size_t Octets = (Entete.MaxGris > 255) ? 2 : 1;
+
+  INSTRUMENTER("decoderBinaire");
+  if ((size_t) (Fin - Entete.Donnees) < (size_t) Entete.w * Entete.h * Octets)
+    {
+      cout << "le fichier est tronqué" << endl;
+      Ok = false;
+      return;
+    }
+  COMPTER_PIXELS((size_t) Entete.w * Entete.h);
+  COMPTER_LECTURE((size_t) Entete.w * Entete.h * Octets);
+  Image->allouer(Entete.h, Entete.w);
+  COMPTER_ALLOCATION((size_t) Image->h * Image->stride);
+  for (i=0;i<Image->h;i=i+1)
+    decoderLigneBinaire(p, (unsigned int) Entete.MaxGris, Image->w, Image->ligne(i));
+}
 
 /*
 Action ChargeImage(NomImage,Image,Ok)
 Paramètre d'entrée : t-Chaine NomImage
 Paramètres de sortie : t_Image Image, booléen Ok
 But : charge, dans la variable Image, l'image donnée au format PGM 
-dans le fichier NomImage. Le booléen Ok indique si le chargement
+(P2 ou P5) dans le fichier NomImage. Le booléen Ok indique si le chargement
 s'est effectué normalement.
+Rq : le fichier est projeté en mémoire puis décodé sur place. Les niveaux
+de gris sont ramenés sur [0, 255] quelle que soit la valeur de MaxGris.
+Un fichier P5 de MaxGris 255 n'est pas recopié : Image devient une vue
+sur la projection, qui est rendue à la destruction ou à la réallocation
+de Image.
 */
 void loadPgm(string NomImage, t_Image * Image, bool & Ok)
 {
-  char c1,c2;
-  int MaxGris,i,j;
-  fstream Fic;
+  void * Bloc;
+  size_t Taille;
+  t_EntetePgm Entete;
 	
+  INSTRUMENTER("loadPgm");
   Ok = true;
-  Fic.open(NomImage,ios::in);
-  Fic >> c1 >> c2; 
-  if ((c1 == 'P')&&(c2=='2'))
+  if (!projeterFichier(NomImage, Bloc, Taille))
+    {
+      cout << "impossible de lire le fichier" << endl;
+      Ok = false;
+      return;
+    }
+  const char * Debut = (const char *) Bloc;
+  const char * Fin = Debut + Taille;
+
+  lireEntete(Debut, Fin, Entete, Ok);
+  if (Ok)
+    COMPTER_PIXELS((size_t) Entete.w * Entete.h);
+  if (Ok && (Entete.Type == '5') && (Entete.MaxGris == 255))
     {
-      Fic >> Image->w >> Image->h;
-      if ((Image->w <= TMAX) && (Image->h <= TMAX))
+      if ((size_t) (Fin - Entete.Donnees) < (size_t) Entete.w * Entete.h)
 	{
-	  Fic >> MaxGris;
-	  if (MaxGris == 255)
-	    {
-	      for (i=0;i<Image->h; i=i+1)
-		{
-		  for (j=0;j<Image->w;j=j+1)
-		    {
-		      Fic >> Image->im[i][j];
-		    }
-		}
-	      cout << "chargement terminé." << endl;
-	    }
-	  else
-	    {
-	      cout << "la plus grande valeur de niveau de gris ne vaut pas 255" << endl;
-	      Ok = false;
-	    }
+	  cout << "le fichier est tronqué" << endl;
+	  Ok = false;
 	}
       else
 	{
-	  cout << "la taille de l'image est trop grande" << endl;
-	  Ok = false;
+	  Image->adopter((t_Pixel *) Entete.Donnees, Entete.h, Entete.w, Entete.w,
+			 Bloc, Taille, libererProjection);
+	  cout << "chargement terminé." << endl;
+	  return;
 	}
     }
-  else
+  else if (Ok && (Entete.Type == '2'))
+    decoderAscii(Entete, Fin, Image, Ok);
+  else if (Ok)
+    decoderBinaire(Entete, Fin, Image, Ok);
+  munmap(Bloc, Taille);
+  if (Ok)
+    cout << "chargement terminé." << endl;
+}
+
+//sorties du chargement avec seuillage : image 8 bits (0 ou 255) ou
+//image binaire compactée (un bit à 1 par pixel noir)
+static inline const char * nomChargement(const t_Image *)
+{
+  return "loadPgmSeuil";
+}
+
+static inline const char * nomChargement(const t_ImageBinaire *)
+{
+  return "loadPgmSeuilBinaire";
+}
+
+static inline size_t octetsAlloues(const t_Image * Image)
+{
+  return (size_t) Image->h * Image->stride;
+}
+
+static inline size_t octetsAlloues(const t_ImageBinaire * Image)
+{
+  return Image->bits.size() * sizeof(uint64_t);
+}
+
+static void ecrireLigneSeuillee(const t_Noyaux & Noyaux, t_Image * Image, int i, const t_Pixel * Ligne,
+				t_Pixel Seuil)
+{
+  Noyaux.seuillerLigne(Image->ligne(i), Ligne, Image->w, Seuil);
+}
+
+static void ecrireLigneSeuillee(const t_Noyaux & Noyaux, t_ImageBinaire * Image, int i, const t_Pixel * Ligne,
+				t_Pixel Seuil)
+{
+  Noyaux.compacterSeuil(Image->ligne(i), Ligne, Image->w, Seuil);
+}
+
+/*
+Action ChargeImageSeuillee(NomImage, Seuil, Image, Ok)
+But : charge le fichier PGM NomImage en appliquant le seuillage pendant le
+décodage, ligne par ligne : l'image en niveaux de gris n'est jamais
+construite. Les lignes d'un fichier P5 de MaxGris 255 sont lues
+directement dans la projection, par bandes réparties entre les threads ;
+les autres formats sont décodés ligne par ligne dans un tampon d'une
+ligne, qui reste dans le cache.
+*/
+template <typename t_Sortie>
+static void chargerSeuille(const string & NomImage, unsigned int Seuil, t_Sortie * Image, bool & Ok)
+{
+  int i;
+  void * Bloc;
+  size_t Taille;
+  t_EntetePgm Entete;
+  const t_Noyaux & Noyaux = noyaux();
+
+  assert(Seuil <= 255 && "La valeur du seuil doit respecter : 0 <= s <= 255");
+  INSTRUMENTER(nomChargement(Image));
+  Ok = true;
+  if (!projeterFichier(NomImage, Bloc, Taille))
     {
-      cout << "le fichier n'est pas au format PGM" << endl;
+      cout << "impossible de lire le fichier" << endl;
+      Ok = false;
+      return;
+    }
+  const char * Debut = (const char *) Bloc;
+  const char * Fin = Debut + Taille;
+
+  lireEntete(Debut, Fin, Entete, Ok);
+  if (Ok && (Entete.Type == '5')
+      && ((size_t) (Fin - Entete.Donnees) < (size_t) Entete.w * Entete.h * ((Entete.MaxGris > 255) ? 2 : 1)))
+    {
+      cout << "le fichier est tronqué" << endl;
       Ok = false;
     }
+  if (Ok)
+    {
+      COMPTER_PIXELS((size_t) Entete.w * Entete.h);
+      COMPTER_LECTURE(Fin - Entete.Donnees);
+      Image->allouer(Entete.h, Entete.w);
+      COMPTER_ALLOCATION(octetsAlloues(Image));
+    }
+  if (Ok && (Entete.Type == '5') && (Entete.MaxGris == 255))
+    {
+      const t_Pixel * Pixels = (const t_Pixel *) Entete.Donnees;
+      pourBandes(Entete.h, 0, 0, [&](const t_Bande & Bande) {
+	for (int y = Bande.y0; y < Bande.y1; y++)
+	  ecrireLigneSeuillee(Noyaux, Image, y, Pixels + (size_t) y * Entete.w, (t_Pixel) Seuil);
+      });
+    }
+  else if (Ok)
+    {
+      vector<t_Pixel> Tampon((size_t) Entete.w);
+      const char * p = Entete.Donnees;
+      const unsigned char * q = (const unsigned char *) Entete.Donnees;
+      for (i=0;(i<Entete.h) && Ok;i=i+1)
+	{
+	  if (Entete.Type == '2')
+	    decoderLigneAscii(p, Fin, (unsigned int) Entete.MaxGris, Entete.w, Tampon.data(), Ok);
+	  else
+	    decoderLigneBinaire(q, (unsigned int) Entete.MaxGris, Entete.w, Tampon.data());
+	  if (Ok)
+	    ecrireLigneSeuillee(Noyaux, Image, i, Tampon.data(), (t_Pixel) Seuil);
+	}
+    }
+  munmap(Bloc, Taille);
+  if (Ok)
+    cout << "chargement terminé." << endl;
+}
+
+/*
+Action ChargeImageSeuillee(NomImage, Seuil, Image, Ok)
+But : voir chargesauve.h.
+*/
+void loadPgmSeuil(string NomImage, unsigned int Seuil, t_Image * Image, bool & Ok)
+{
+  chargerSeuille(NomImage, Seuil, Image, Ok);
+}
+
+void loadPgmSeuil(string NomImage, unsigned int Seuil, t_ImageBinaire * Image, bool & Ok)
+{
+  chargerSeuille(NomImage, Seuil, Image, Ok);
+}
+
+/*
+Action SauveImageBinaire(NomImage, Image)
+But : enregistre Image au format PGM binaire (P5). Les pixels sont écrits
+d'un seul bloc ; si les lignes de Image ne sont pas jointives (stride > w),
+elles sont d'abord regroupées dans un tampon unique.
+*/
+static void savePgmBinaire(const string & NomImage, t_Image * Image)
+{
+  int i;
+  fstream Fic;
+  const size_t TailleLigne = (size_t) Image->w;
+
+  INSTRUMENTER("savePgmBinaire");
+  COMPTER_PIXELS((size_t) Image->w * Image->h);
+  COMPTER_LECTURE(TailleLigne * Image->h);
+  Fic.open(NomImage,ios::out | ios::binary);
+  Fic << "P5" << '\n';
+  Fic << Image->w << ' ' << Image->h << '\n';
+  Fic << "255" << '\n';
+  if (Image->stride == Image->w)
+    Fic.write((const char *) Image->pixels, (streamsize) (TailleLigne * Image->h));
+  else
+    {
+      string Trame(TailleLigne * Image->h, '\0');
+      COMPTER_ALLOCATION(Trame.size());
+      for (i=0;i<Image->h;i=i+1)
+	memcpy(&Trame[TailleLigne * i], Image->ligne(i), TailleLigne);
+      Fic.write(Trame.data(), (streamsize) Trame.size());
+    }
   Fic.close();
 }
 
 /*
-Action SauveImage(NomImage, Image)
-Paramètres d'entrée : t_Chaine NomImage, t_Image Image
-Rq : Image, qui occupe beaucoup de place en mémoire, sera passée par adresse 
-pour éviter de doubler cette place mémoire pendant l'exécution de l'action.
-But : enregistre au format PGM, dans le fichier NomImage, l'image représentée
-dans la variable Image.
+Action OuvrePgm(NomImage, h, w, Ok)
+But : voir chargesauve.h. Le fichier est projeté en mémoire et décodé au
+fur et à mesure des lectures ; les pages déjà lues sont rendues au
+système, pour que la mémoire occupée ne dépende pas de la hauteur.
 */
-void savePgm(string NomImage, t_Image * Image)
+struct t_LecteurPgm
+{
+  void * Bloc;
+  size_t Taille;
+  t_EntetePgm Entete;
+  const char * p;       //premier pixel non lu
+  const char * Fin;
+  const char * Rendu;   //début des pages pas encore rendues
+};
+
+//taille des blocs de pages lues rendus d'un coup
+const size_t BLOC_RENDU = 1 << 22;
+
+t_LecteurPgm * ouvrirPgm(string NomImage, int & h, int & w, bool & Ok)
+{
+  t_LecteurPgm * Lecteur = new t_LecteurPgm;
+
+  Ok = true;
+  if (!projeterFichier(NomImage, Lecteur->Bloc, Lecteur->Taille))
+    {
+      cout << "impossible de lire le fichier" << endl;
+      delete Lecteur;
+      Ok = false;
+      return nullptr;
+    }
+  const char * Debut = (const char *) Lecteur->Bloc;
+  Lecteur->Fin = Debut + Lecteur->Taille;
+  lireEntete(Debut, Lecteur->Fin, Lecteur->Entete, Ok);
+  if (Ok && (Lecteur->Entete.Type == '5')
+      && ((size_t) (Lecteur->Fin - Lecteur->Entete.Donnees)
+	  < (size_t) Lecteur->Entete.w * Lecteur->Entete.h * ((Lecteur->Entete.MaxGris > 255) ? 2 : 1)))
+    {
+      cout << "le fichier est tronqué" << endl;
+      Ok = false;
+    }
+  if (!Ok)
+    {
+      fermerPgm(Lecteur);
+      return nullptr;
+    }
+  madvise(Lecteur->Bloc, Lecteur->Taille, MADV_SEQUENTIAL);
+  Lecteur->p = Lecteur->Entete.Donnees;
+  Lecteur->Rendu = Debut;
+  h = Lecteur->Entete.h;
+  w = Lecteur->Entete.w;
+  return Lecteur;
+}
+
+/*
+Action LitLignePgm(Lecteur, Ligne, Ok)
+But : décode la ligne suivante du fichier dans Ligne (w pixels ramenés
+sur [0, 255]). Ok devient faux si le fichier est tronqué.
+*/
+void lireLignePgm(t_LecteurPgm * Lecteur, t_Pixel * Ligne, bool & Ok)
+{
+  const t_EntetePgm & Entete = Lecteur->Entete;
+
+  INSTRUMENTER("lireLignePgm");
+  COMPTER_PIXELS(Entete.w);
+  Ok = true;
+  if (Entete.Type == '2')
+    decoderLigneAscii(Lecteur->p, Lecteur->Fin, (unsigned int) Entete.MaxGris, Entete.w, Ligne, Ok);
+  else if (Entete.MaxGris == 255)
+    {
+      memcpy(Ligne, Lecteur->p, (size_t) Entete.w);
+      Lecteur->p = Lecteur->p + Entete.w;
+    }
+  else
+    {
+      const unsigned char * q = (const unsigned char *) Lecteur->p;
+      decoderLigneBinaire(q, (unsigned int) Entete.MaxGris, Entete.w, Ligne);
+      Lecteur->p = (const char *) q;
+    }
+  //rend les pages entièrement lues, par blocs alignés
+  const size_t Page = (size_t) sysconf(_SC_PAGESIZE);
+  const size_t Lus = (size_t) (Lecteur->p - Lecteur->Rendu) / Page * Page;
+  if (Lus >= BLOC_RENDU)
+    {
+      madvise((void *) Lecteur->Rendu, Lus, MADV_DONTNEED);
+      Lecteur->Rendu = Lecteur->Rendu + Lus;
+    }
+}
+
+/*
+Action FermePgm(Lecteur)
+But : rend la projection du fichier et libère le lecteur.
+*/
+void fermerPgm(t_LecteurPgm * Lecteur)
+{
+  if (Lecteur == nullptr)
+    return;
+  munmap(Lecteur->Bloc, Lecteur->Taille);
+  delete Lecteur;
+}
+
+/*
+Action CreePgm(NomImage, h, w, Format)
+But : voir chargesauve.h. Les lignes sont formatées dans un tampon vidé
+dans le fichier chaque fois qu'il est plein.
+*/
+//taille du tampon d'écriture
+const size_t TAMPON_ECRITURE = 1 << 20;
+
+struct t_EcrivainPgm
 {
-  int k,i,j;
   fstream Fic;
-	
-  Fic.open(NomImage,ios::out);
-  Fic << "P2" << endl;
-  Fic << Image->w << ' ' << Image->h << endl;
-  Fic << "255" << endl;
-  k = 0;
-  for (i=0;i<Image->h;i=i+1)
+  t_FormatPgm Format;
+  int w;
+  string Tampon;
+  char * q;   //fin des données du tampon
+  int k;      //largeur approximative de la ligne de texte en cours (P2)
+};
+
+//écriture en texte de chaque niveau de gris, calculée une seule fois
+struct t_TextesGris
+{
+  char Textes[256][4];
+  unsigned char Longueurs[256];
+
+  t_TextesGris()
+  {
+    for (int i=0;i<256;i=i+1)
+      Longueurs[i] = (unsigned char) snprintf(Textes[i], sizeof(Textes[i]), "%d", i);
+  }
+};
+
+static const t_TextesGris & textesGris()
+{
+  static const t_TextesGris Instance;
+  return Instance;
+}
+
+static void viderTampon(t_EcrivainPgm * Ecrivain)
+{
+  Ecrivain->Fic.write(&Ecrivain->Tampon[0], Ecrivain->q - &Ecrivain->Tampon[0]);
+  Ecrivain->q = &Ecrivain->Tampon[0];
+}
+
+t_EcrivainPgm * creerPgm(string NomImage, int h, int w, t_FormatPgm Format)
+{
+  t_EcrivainPgm * Ecrivain = new t_EcrivainPgm;
+
+  Ecrivain->Format = Format;
+  Ecrivain->w = w;
+  Ecrivain->Tampon.assign(TAMPON_ECRITURE + 128, '\0');
+  Ecrivain->q = &Ecrivain->Tampon[0];
+  Ecrivain->k = 0;
+  Ecrivain->Fic.open(NomImage, (Format == PGM_BINAIRE) ? ios::out | ios::binary : ios::out);
+  Ecrivain->Fic << ((Format == PGM_BINAIRE) ? "P5" : "P2") << '\n';
+  Ecrivain->Fic << w << ' ' << h << '\n';
+  Ecrivain->Fic << "255" << '\n';
+  return Ecrivain;
+}
+
+/*
+Action EcritLignePgm(Ecrivain, Ligne)
+But : ajoute au fichier la ligne suivante de l'image (w pixels).
+*/
+void ecrireLignePgm(t_EcrivainPgm * Ecrivain, const t_Pixel * Ligne)
+{
+  int j;
+  const t_TextesGris & Gris = textesGris();
+
+  if (Ecrivain->Format == PGM_BINAIRE)
     {
-      for (j=0;j<Image->w;j=j+1)
+      if ((size_t) (Ecrivain->q - &Ecrivain->Tampon[0]) + Ecrivain->w > TAMPON_ECRITURE)
+	viderTampon(Ecrivain);
+      if ((size_t) Ecrivain->w > TAMPON_ECRITURE)
+	Ecrivain->Fic.write((const char *) Ligne, Ecrivain->w);
+      else
 	{
-	  Fic << Image->im[i][j] << ' ';
-	  k=k+4;
-	  if (k > 67)
-	    {
-	      Fic << endl;
-        k = 0;
-	    }
+	  memcpy(Ecrivain->q, Ligne, (size_t) Ecrivain->w);
+	  Ecrivain->q = Ecrivain->q + Ecrivain->w;
 	}
+      return;
+    }
+  for (j=0;j<Ecrivain->w;j=j+1)
+    {
+      memcpy(Ecrivain->q, Gris.Textes[Ligne[j]], 4);
+      Ecrivain->q = Ecrivain->q + Gris.Longueurs[Ligne[j]];
+      *Ecrivain->q = ' ';
+      Ecrivain->q = Ecrivain->q + 1;
+      Ecrivain->k = Ecrivain->k + 4;
+      if (Ecrivain->k > 67)
+	{
+	  *Ecrivain->q = '\n';
+	  Ecrivain->q = Ecrivain->q + 1;
+	  Ecrivain->k = 0;
+	}
+      if ((size_t) (Ecrivain->q - &Ecrivain->Tampon[0]) >= TAMPON_ECRITURE)
+	viderTampon(Ecrivain);
     }
-  Fic.close();
-  cout << "sauvegarde terminée." << endl;
 }
 
+/*
+Action FermePgm(Ecrivain)
+But : écrit la fin du tampon, ferme le fichier et libère l'écrivain.
+*/
+void fermerPgm(t_EcrivainPgm * Ecrivain)
+{
+  if (Ecrivain == nullptr)
+    return;
+  viderTampon(Ecrivain);
+  Ecrivain->Fic.close();
+  delete Ecrivain;
+}
 
-
-				
+/*
+Action SauveImage(NomImage, Image, Format)
+Paramètres d'entrée : t_Chaine NomImage, t_Image Image, t_FormatPgm Format
+Rq : Image, qui occupe beaucoup de place en mémoire, sera passée par adresse 
+pour éviter de doubler cette place mémoire pendant l'exécution de l'action.
+But : enregistre au format PGM (P2 par défaut, P5 si Format vaut
+PGM_BINAIRE), dans le fichier NomImage, l'image représentée
+dans la variable Image.
+*/
+void savePgm(string NomImage, t_Image * Image, t_FormatPgm Format)
+{
+  int i;
 	
+  INSTRUMENTER("savePgm");
+  COMPTER_PIXELS((size_t) Image->w * Image->h);
+  if (Format == PGM_BINAIRE)
+    {
+      savePgmBinaire(NomImage, Image);
+      cout << "sauvegarde terminée." << endl;
+      return;
+    }
+  COMPTER_ALLOCATION(TAMPON_ECRITURE + 128);
+  COMPTER_LECTURE((size_t) Image->w * Image->h);
+  t_EcrivainPgm * Ecrivain = creerPgm(NomImage, Image->h, Image->w, PGM_ASCII);
+  for (i=0;i<Image->h;i=i+1)
+    ecrireLignePgm(Ecrivain, Image->ligne(i));
+  fermerPgm(Ecrivain);
+  cout << "sauvegarde terminée." << endl;
+}
@@ -10,8 +10,15 @@ qui liront et écriront des fichiers PGM
 
 #ifndef __secsmp_chargesauve
 #define __secsmp_chargesauve
+#include <string>
 #include "image.h"
 using namespace std;
+
+struct t_ImageBinaire;
+
+//format d'enregistrement d'un fichier PGM :
+//P2 (niveaux de gris écrits en texte) ou P5 (un octet par pixel)
+enum t_FormatPgm { PGM_ASCII, PGM_BINAIRE };
 /*
 Action ChargeImage(NomImage,Image,Ok)
 Paramètre d'entrée : t-Chaine NomImage
@@ -19,18 +26,62 @@ Paramètres de sortie : t_Image Image, booléen Ok
 But : charge, dans la variable Image, l'image donnée au format PGM 
 dans le fichier NomImage. Le booléen Ok indique si le chargement
 s'est effectué normalement.
+Rq : un fichier P5 est projeté en mémoire ; Image devient alors une vue
+sur les pixels du fichier, sans recopie. Les modifications apportées à
+Image restent privées et ne sont jamais écrites dans le fichier.
 */
 void loadPgm(string NomImage, t_Image * Image, bool & Ok);
 
 /*
-Action SauveImage(NomImage, Image)
-Paramètres d'entrée : t_Chaine NomImage, t_Image Image
+Action ChargeImageSeuillee(NomImage, Seuil, Image, Ok)
+Paramètres d'entrée : t-Chaine NomImage, entier Seuil (0 à 255)
+Paramètres de sortie : t_Image ou t_ImageBinaire Image, booléen Ok
+But : équivaut à ChargeImage suivie de seuillage(Image, Seuil), mais le
+seuil est appliqué pendant le décodage : l'image en niveaux de gris n'est
+jamais construite. Une t_ImageBinaire reçoit un bit à 1 pour chaque pixel
+inférieur au seuil (voir binaire.h), soit 8 fois moins de mémoire.
+*/
+void loadPgmSeuil(string NomImage, unsigned int Seuil, t_Image * Image, bool & Ok);
+void loadPgmSeuil(string NomImage, unsigned int Seuil, t_ImageBinaire * Image, bool & Ok);
+
+/*
+Action SauveImage(NomImage, Image, Format)
+Paramètres d'entrée : t_Chaine NomImage, t_Image Image, t_FormatPgm Format
 Rq : Image, qui occupe beaucoup de place en mémoire, sera passée par adresse 
 pour éviter de doubler cette place mémoire pendant l'exécution de l'action.
-But : enregistre au format PGM, dans le fichier NomImage, l'image représentée
+But : enregistre au format PGM (P2 par défaut, P5 si Format vaut
+PGM_BINAIRE), dans le fichier NomImage, l'image représentée
 dans la variable Image.
 */
-void savePgm(string NomImage, t_Image * Image);
+void savePgm(string NomImage, t_Image * Image, t_FormatPgm Format = PGM_ASCII);
+
+/*
+Lecture et écriture ligne à ligne, pour les images trop grandes pour
+tenir en mémoire (voir t_Pipeline::executerParBandes) : seules les
+lignes en cours de lecture ou d'écriture sont en mémoire.
+
+Action OuvrePgm(NomImage, h, w, Ok)
+Paramètre d'entrée : t-Chaine NomImage
+Paramètres de sortie : entiers h et w, booléen Ok
+But : ouvre le fichier PGM NomImage (P2 ou P5) et lit son entête.
+Renvoie le lecteur, ou nullptr si Ok est faux. Les lignes sont lues
+dans l'ordre par lireLignePgm ; fermerPgm libère le lecteur.
+*/
+struct t_LecteurPgm;
+t_LecteurPgm * ouvrirPgm(string NomImage, int & h, int & w, bool & Ok);
+void lireLignePgm(t_LecteurPgm * Lecteur, t_Pixel * Ligne, bool & Ok);
+void fermerPgm(t_LecteurPgm * Lecteur);
+
+/*
+Action CreePgm(NomImage, h, w, Format)
+But : crée le fichier PGM NomImage de dimensions h x w et en écrit
+l'entête. Les h lignes sont ensuite écrites dans l'ordre par
+ecrireLignePgm ; fermerPgm termine le fichier et libère l'écrivain.
+*/
+struct t_EcrivainPgm;
+t_EcrivainPgm * creerPgm(string NomImage, int h, int w, t_FormatPgm Format = PGM_ASCII);
+void ecrireLignePgm(t_EcrivainPgm * Ecrivain, const t_Pixel * Ligne);
+void fermerPgm(t_EcrivainPgm * Ecrivain);
 
 #endif
 
@@ -0,0 +1,229 @@
+//
+// Étiquetage des composantes connexes d'une image binaire et mesure de chaque
+// composante (aire, rectangle englobant, centre de gravité).
+//
+
+#include "outils.h"
+#include "instrumentation.h"
+#include "noyaux.h"
+#include "parallele.h"
+#include <algorithm>
+
+/*
+ * Étiquetage par plages : chaque ligne est découpée en plages de pixels
+ * consécutifs de l'objet, lues sur la ligne compactée en bits (un mot de 64
+ * pixels à la fois, voir compacterSeuil), et chaque plage reçoit une étiquette
+ * provisoire. Une union-find relie les plages qui se touchent d'une ligne à la
+ * suivante : en 4-connexité quand elles se recouvrent, en 8-connexité aussi
+ * quand elles ne se touchent que par un coin. Les plages ne sont comparées
+ * qu'à celles de la ligne précédente, dans l'ordre : le coût dépend du nombre
+ * de plages, non du nombre de pixels.
+ *
+ * En parallèle, chaque bande de lignes découpe et relie ses plages de son côté ;
+ * les bandes sont ensuite raccordées en reliant la première ligne de chacune à
+ * la dernière de la précédente. Une union rattache toujours la racine la plus
+ * grande à la plus petite : la racine d'une composante est sa première plage
+ * dans l'ordre des lignes, et les étiquettes définitives (1, 2, ...) suivent
+ * l'ordre de leur premier pixel, quel que soit le nombre de threads.
+ */
+
+// plage [x0, x1) de la ligne y
+typedef struct {
+    int x0, x1, y;
+} t_Plage;
+
+// racine de la plage i, en raccourcissant le chemin parcouru
+static uint32_t racine(std::vector<uint32_t> &parent, uint32_t i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+static void unir(std::vector<uint32_t> &parent, const uint32_t a, const uint32_t b) {
+    const uint32_t ra = racine(parent, a), rb = racine(parent, b);
+    if (ra < rb)
+        parent[rb] = ra;
+    else if (rb < ra)
+        parent[ra] = rb;
+}
+
+/**
+ * @brief Ajoute à @p plages les plages de l'objet (pixels BLACK) de la ligne y.
+ *
+ * @param bits Tampon d'au moins (w + 63) / 64 mots.
+ */
+static void decouperLigne(const t_Pixel *ligne, const int w, const int y, uint64_t *bits,
+                          std::vector<t_Plage> &plages) {
+    noyaux().compacterSeuil(bits, ligne, w, BLACK + 1);
+    const int mots = (w + 63) / 64;
+    int debut = -1;
+    for (int m = 0; m < mots; m++) {
+        uint64_t mot = bits[m];
+        int x = m * 64;
+        const int fin = std::min(w, x + 64);
+        // alternance des bits à 1 (objet) et à 0 (fond) du mot
+        while (x < fin) {
+            if (debut < 0) {
+                if (mot == 0)
+                    break;
+                const int saut = __builtin_ctzll(mot);
+                x += saut;
+                mot >>= saut;
+                debut = x;
+            }
+            const int longueur = ~mot == 0 ? 64 : __builtin_ctzll(~mot);
+            if (x + longueur >= m * 64 + 64)
+                break;                  // la plage continue dans le mot suivant
+            x += longueur;
+            mot >>= longueur;
+            plages.push_back({debut, x, y});
+            debut = -1;
+        }
+    }
+    if (debut >= 0)
+        plages.push_back({debut, w, y});
+}
+
+/**
+ * @brief Relie les plages [a0, a1) d'une ligne à celles [b0, b1) de la ligne
+ *        suivante qui les touchent.
+ *
+ * @param coin 1 en 8-connexité (contact par un coin accepté), 0 en 4-connexité.
+ */
+static void relierLignes(const std::vector<t_Plage> &plages, std::vector<uint32_t> &parent, uint32_t a,
+                         const uint32_t a1, uint32_t b, const uint32_t b1, const int coin) {
+    while (a < a1 && b < b1) {
+        const t_Plage &pa = plages[a], &pb = plages[b];
+        if (pa.x0 < pb.x1 + coin && pb.x0 < pa.x1 + coin)
+            unir(parent, a, b);
+        // la plage qui finit la première ne touche plus aucune plage suivante de l'autre ligne
+        if (pa.x1 < pb.x1)
+            a++;
+        else
+            b++;
+    }
+}
+
+/**
+ * @brief Étiquette les composantes connexes de l'objet (pixels BLACK) d'une
+ *        image binaire et mesure chacune d'elles.
+ *
+ * @param image       Image binaire (objet à 0, tout autre niveau est du fond).
+ * @param etiquettes  Reçoit l'étiquette de chaque pixel : 0 pour le fond, 1 à n
+ *                    pour les composantes, numérotées dans l'ordre de leur
+ *                    premier pixel (ligne par ligne). Peut valoir nullptr si
+ *                    seules les mesures sont demandées.
+ * @param composantes Reçoit les n composantes, (*composantes)[k - 1] décrivant
+ *                    l'étiquette k. Peut valoir nullptr.
+ * @param connexite   CONNEXITE_4 ou CONNEXITE_8.
+ *
+ * @return Nombre n de composantes.
+ *
+ * @pre image != nullptr
+ */
+int etiqueter(const t_Image *image, t_Etiquettes *etiquettes, std::vector<t_Composante> *composantes,
+              const t_Connexite connexite) {
+    INSTRUMENTER("etiqueter");
+    COMPTER_PIXELS((size_t) image->w * image->h);
+    COMPTER_LECTURE((size_t) image->w * image->h);
+    const int w = image->w, h = image->h;
+    const int coin = connexite == CONNEXITE_8 ? 1 : 0;
+    const std::vector<t_Bande> bandes = decouperBandes(h, 0, 0);
+    const int nombreBandes = (int) bandes.size();
+
+    // 1. plages de chaque bande
+    std::vector<std::vector<t_Plage> > plagesBandes(nombreBandes);
+    std::vector<std::vector<uint32_t> > debutsBandes(nombreBandes);
+    executerTaches(nombreBandes, [&](const int k) {
+        std::vector<uint64_t> bits((w + 63) / 64 + 1);
+        for (int y = bandes[k].y0; y < bandes[k].y1; y++) {
+            debutsBandes[k].push_back((uint32_t) plagesBandes[k].size());
+            decouperLigne(image->ligne(y), w, y, bits.data(), plagesBandes[k]);
+        }
+    });
+
+    // 2. plages de toute l'image, rangées par ligne : debut[y] est l'indice de
+    // la première plage de la ligne y
+    std::vector<uint32_t> decalage(nombreBandes + 1, 0);
+    for (int k = 0; k < nombreBandes; k++)
+        decalage[k + 1] = decalage[k] + (uint32_t) plagesBandes[k].size();
+    const uint32_t nombrePlages = decalage[nombreBandes];
+    std::vector<t_Plage> plages(nombrePlages);
+    std::vector<uint32_t> debut(h + 1, nombrePlages), parent(nombrePlages);
+    executerTaches(nombreBandes, [&](const int k) {
+        std::copy(plagesBandes[k].begin(), plagesBandes[k].end(), plages.begin() + decalage[k]);
+        for (int y = bandes[k].y0; y < bandes[k].y1; y++)
+            debut[y] = decalage[k] + debutsBandes[k][y - bandes[k].y0];
+        for (uint32_t i = decalage[k]; i < decalage[k + 1]; i++)
+            parent[i] = i;
+        std::vector<t_Plage>().swap(plagesBandes[k]);
+        // 3. unions à l'intérieur de la bande : les indices de ses plages ne
+        // sont touchés par aucune autre tâche
+        for (int y = bandes[k].y0 + 1; y < bandes[k].y1; y++) {
+            const uint32_t fin = y + 1 < bandes[k].y1 ? debut[y + 1] : decalage[k + 1];
+            relierLignes(plages, parent, debut[y - 1], debut[y], debut[y], fin, coin);
+        }
+    });
+
+    // 4. raccord des bandes
+    for (int k = 1; k < nombreBandes; k++) {
+        const int y = bandes[k].y0;
+        relierLignes(plages, parent, debut[y - 1], debut[y], debut[y], debut[y + 1], coin);
+    }
+
+    // 5. étiquettes définitives : la racine précède toujours les plages de sa
+    // composante, dont l'étiquette est donc connue quand on les atteint
+    std::vector<uint32_t> etiquette(nombrePlages);
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < nombrePlages; i++)
+        etiquette[i] = parent[i] == i ? ++n : etiquette[racine(parent, i)];
+
+    if (composantes != nullptr) {
+        struct t_Sommes {
+            uint64_t aire, sommeX, sommeY;
+            int x0, y0, x1, y1;
+        };
+        std::vector<t_Sommes> sommes(n, {0, 0, 0, w, h, 0, 0});
+        for (uint32_t i = 0; i < nombrePlages; i++) {
+            const t_Plage &p = plages[i];
+            t_Sommes &s = sommes[etiquette[i] - 1];
+            const uint64_t longueur = (uint64_t) (p.x1 - p.x0);
+            s.aire += longueur;
+            s.sommeX += (uint64_t) (p.x0 + p.x1 - 1) * longueur / 2;
+            s.sommeY += (uint64_t) p.y * longueur;
+            s.x0 = std::min(s.x0, p.x0);
+            s.x1 = std::max(s.x1, p.x1);
+            s.y0 = std::min(s.y0, p.y);
+            s.y1 = p.y + 1;
+        }
+        composantes->resize(n);
+        for (uint32_t k = 0; k < n; k++) {
+            const t_Sommes &s = sommes[k];
+            t_Composante &c = (*composantes)[k];
+            c.aire = s.aire;
+            c.x0 = s.x0;
+            c.y0 = s.y0;
+            c.x1 = s.x1;
+            c.y1 = s.y1;
+            c.cx = (double) s.sommeX / (double) s.aire;
+            c.cy = (double) s.sommeY / (double) s.aire;
+        }
+    }
+
+    if (etiquettes != nullptr) {
+        etiquettes->w = w;
+        etiquettes->h = h;
+        etiquettes->e.resize((size_t) w * h);
+        pourBandes(h, 0, 0, [&](const t_Bande &b) {
+            for (int y = b.y0; y < b.y1; y++) {
+                uint32_t *ligne = etiquettes->e.data() + (size_t) y * w;
+                std::fill(ligne, ligne + w, 0u);
+                for (uint32_t i = debut[y]; i < debut[y + 1]; i++)
+                    std::fill(ligne + plages[i].x0, ligne + plages[i].x1, etiquette[i]);
+            }
+        });
+    }
+    return (int) n;
+}
@@ -0,0 +1,252 @@
+//
+// Transformées en distance et dilatation / érosion par des disques de rayon
+// quelconque.
+//
+
+#include "outils.h"
+#include "parallele.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+
+/*
+ * Transformée euclidienne exacte de Meijster, Roerdink et Hesselink, en deux
+ * passes linéaires :
+ * 1. pour chaque colonne, distance g au pixel objet le plus proche de la même
+ *    colonne (balayage descendant puis montant) ;
+ * 2. pour chaque ligne, d²(x) = min_i (x - i)² + g(i)² : enveloppe inférieure des
+ *    paraboles centrées en chaque i, construite en un seul balayage.
+ * Les colonnes de la première passe et les lignes de la seconde sont réparties
+ * entre les threads.
+ */
+
+// distance (carrée) attribuée aux pixels d'une image sans aucun pixel objet
+static const uint32_t DISTANCE_INFINIE = UINT32_MAX;
+
+/**
+ * @brief Indique si la transformée euclidienne d'une image w x h est
+ *        représentable : le plus grand carré de distance possible,
+ *        (w - 1)² + (h - 1)², doit tenir sur 32 bits sans atteindre
+ *        DISTANCE_INFINIE.
+ */
+bool distanceRepresentable(const int w, const int h) {
+    const uint64_t dx = w > 0 ? (uint64_t) (w - 1) : 0, dy = h > 0 ? (uint64_t) (h - 1) : 0;
+    return dx * dx + dy * dy < DISTANCE_INFINIE;
+}
+
+/**
+ * @brief Carré de la distance euclidienne de chaque pixel au plus proche pixel
+ *        objet : noir (0) si @p objetNoir, non noir sinon.
+ */
+static void transformeeEuclidienne(const t_Image *imgIn, t_CarteDistance *carte, const bool objetNoir) {
+    const int w = imgIn->w, h = imgIn->h;
+    assert(distanceRepresentable(w, h) && "Les carrés des distances doivent tenir sur 32 bits.");
+    carte->w = w;
+    carte->h = h;
+    carte->d.assign((size_t) w * h, 0);
+    if (w == 0 || h == 0)
+        return;
+    const int64_t infini = (int64_t) w + h;
+
+    // passe 1 : colonnes ; chaque tâche traite un paquet de colonnes contiguës,
+    // parcouru ligne par ligne pour lire la mémoire dans l'ordre
+    pourBandes(w, 0, 0, [&](const t_Bande &b) {
+        const uint32_t plafond = (uint32_t) infini;
+        for (int y = 0; y < h; y++) {
+            const t_Pixel *pixels = imgIn->ligne(y);
+            uint32_t *g = carte->d.data() + (size_t) y * w;
+            const uint32_t *dessus = y > 0 ? g - w : nullptr;
+            for (int x = b.y0; x < b.y1; x++) {
+                const uint32_t precedent = dessus != nullptr ? std::min(dessus[x] + 1, plafond) : plafond;
+                g[x] = ((pixels[x] == BLACK) == objetNoir) ? 0 : precedent;
+            }
+        }
+        for (int y = h - 2; y >= 0; y--) {
+            uint32_t *g = carte->d.data() + (size_t) y * w;
+            const uint32_t *dessous = g + w;
+            for (int x = b.y0; x < b.y1; x++)
+                g[x] = std::min(g[x], dessous[x] + 1);
+        }
+    });
+
+    // passe 2 : lignes
+    pourBandes(h, 0, 0, [&](const t_Bande &b) {
+        std::vector<int64_t> g(w);
+        std::vector<int> s(w), t(w);
+        for (int y = b.y0; y < b.y1; y++) {
+            uint32_t *ligne = carte->d.data() + (size_t) y * w;
+            for (int x = 0; x < w; x++)
+                g[x] = ligne[x];
+            auto f = [&](const int64_t x, const int i) { return (x - i) * (x - i) + g[i] * g[i]; };
+            auto separation = [&](const int i, const int u) {
+                return (int64_t) ((u * (int64_t) u - i * (int64_t) i + g[u] * g[u] - g[i] * g[i]) / (2 * (u - i)));
+            };
+
+            int q = 0;
+            s[0] = 0;
+            t[0] = 0;
+            for (int u = 1; u < w; u++) {
+                while (q >= 0 && f(t[q], s[q]) > f(t[q], u))
+                    q--;
+                if (q < 0) {
+                    q = 0;
+                    s[0] = u;
+                } else {
+                    const int64_t debut = 1 + separation(s[q], u);
+                    if (debut < w) {
+                        q++;
+                        s[q] = u;
+                        t[q] = (int) debut;
+                    }
+                }
+            }
+            for (int u = w - 1; u >= 0; u--) {
+                const int64_t d = f(u, s[q]);
+                ligne[u] = g[s[q]] >= infini ? DISTANCE_INFINIE : (uint32_t) d;
+                if (u == t[q])
+                    q--;
+            }
+        }
+    });
+}
+
+/**
+ * @brief Transformée en distance euclidienne exacte.
+ *
+ * Calcule, pour chaque pixel de @p imgIn, le carré de la distance euclidienne au
+ * plus proche pixel noir (BLACK) de l'image, en temps linéaire en le nombre de
+ * pixels. Les carrés sont entiers, donc exacts.
+ *
+ * @param imgIn Image d'entrée (les pixels valant BLACK sont les pixels objet).
+ * @param carte Reçoit les carrés des distances, ligne par ligne ; un pixel
+ *              d'une image sans pixel noir reçoit UINT32_MAX.
+ *
+ * @pre distanceRepresentable(imgIn->w, imgIn->h)
+ */
+void distanceEuclidienne(const t_Image *imgIn, t_CarteDistance *carte) {
+    transformeeEuclidienne(imgIn, carte, true);
+}
+
+/**
+ * @brief Transformée en distance de chanfrein 3-4.
+ *
+ * Approximation de la distance euclidienne en deux balayages (avant puis
+ * arrière) : un pas horizontal ou vertical coûte 3, un pas diagonal 4. La
+ * distance euclidienne vaut environ la valeur obtenue divisée par 3.
+ *
+ * @param imgIn Image d'entrée (les pixels valant BLACK sont les pixels objet).
+ * @param carte Reçoit la distance de chaque pixel au plus proche pixel noir ;
+ *              un pixel d'une image sans pixel noir reçoit UINT32_MAX.
+ */
+void distanceChanfrein(const t_Image *imgIn, t_CarteDistance *carte) {
+    const int w = imgIn->w, h = imgIn->h;
+    carte->w = w;
+    carte->h = h;
+    carte->d.assign((size_t) w * h, DISTANCE_INFINIE);
+    auto d = [&](const int x, const int y) -> uint32_t & { return carte->d[(size_t) y * w + x]; };
+    auto relacher = [&](uint32_t &cible, const int x, const int y, const uint32_t cout) {
+        if (x >= 0 && x < w && y >= 0 && y < h && d(x, y) != DISTANCE_INFINIE)
+            cible = std::min(cible, d(x, y) + cout);
+    };
+
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++) {
+            uint32_t &courant = d(x, y);
+            if (imgIn->ligne(y)[x] == BLACK) {
+                courant = 0;
+                continue;
+            }
+            relacher(courant, x - 1, y, 3);
+            relacher(courant, x - 1, y - 1, 4);
+            relacher(courant, x, y - 1, 3);
+            relacher(courant, x + 1, y - 1, 4);
+        }
+    for (int y = h - 1; y >= 0; y--)
+        for (int x = w - 1; x >= 0; x--) {
+            uint32_t &courant = d(x, y);
+            relacher(courant, x + 1, y, 3);
+            relacher(courant, x + 1, y + 1, 4);
+            relacher(courant, x, y + 1, 3);
+            relacher(courant, x - 1, y + 1, 4);
+        }
+}
+
+/**
+ * @brief Remplit de @p fillColor les pixels dont le carré de la distance est
+ *        au plus rayon² (ou strictement supérieur si @p auDela).
+ */
+static void seuillerCarte(const t_CarteDistance &carte, t_Image *imgOut, const unsigned int rayon,
+                          const bool auDela, const unsigned int fillColor) {
+    const uint64_t limite = (uint64_t) rayon * rayon;
+    pourBandes(carte.h, 0, 0, [&](const t_Bande &b) {
+        for (int y = b.y0; y < b.y1; y++) {
+            const uint32_t *d = carte.d.data() + (size_t) y * carte.w;
+            t_Pixel *sortie = imgOut->ligne(y);
+            for (int x = 0; x < carte.w; x++)
+                if ((d[x] <= limite) != auDela)
+                    sortie[x] = (t_Pixel) fillColor;
+        }
+    });
+}
+
+/**
+ * @brief Dilatation par le disque de rayon @p rayon (cellules dx² + dy² <= rayon²),
+ *        en un temps indépendant du rayon.
+ *
+ * Même résultat que dilatation() avec l'élément disque centré de même rayon :
+ * un pixel reçoit @p fillColor si un pixel noir de l'image est à une distance
+ * euclidienne au plus @p rayon.
+ *
+ * @pre imgOut a les dimensions de imgIn
+ * @pre distanceRepresentable(imgIn->w, imgIn->h)
+ * @pre 0 <= fillColor <= 255
+ */
+void dilatationDisque(const t_Image *imgIn, t_Image *imgOut, const unsigned int rayon, const unsigned int fillColor) {
+    assert(imgOut->w == imgIn->w && imgOut->h == imgIn->h);
+    assert(fillColor <= 255 && "La valeur de la couleur de remplissage doit respecter : 0 <= s <= 255");
+    t_CarteDistance carte;
+    transformeeEuclidienne(imgIn, &carte, true);
+    seuillerCarte(carte, imgOut, rayon, false, fillColor);
+}
+
+/**
+ * @brief Érosion par le disque de rayon @p rayon, en un temps indépendant du
+ *        rayon.
+ *
+ * Même résultat que erosion() avec l'élément disque centré de même rayon : un
+ * pixel reçoit @p fillColor si aucun pixel non noir de l'image n'est à une
+ * distance euclidienne au plus @p rayon (l'extérieur de l'image est ignoré).
+ *
+ * @pre imgOut a les dimensions de imgIn
+ * @pre distanceRepresentable(imgIn->w, imgIn->h)
+ * @pre 0 <= fillColor <= 255
+ */
+void erosionDisque(const t_Image *imgIn, t_Image *imgOut, const unsigned int rayon, const unsigned int fillColor) {
+    assert(imgOut->w == imgIn->w && imgOut->h == imgIn->h);
+    assert(fillColor <= 255 && "La valeur de la couleur de remplissage doit respecter : 0 <= s <= 255");
+    t_CarteDistance carte;
+    transformeeEuclidienne(imgIn, &carte, false);
+    seuillerCarte(carte, imgOut, rayon, true, fillColor);
+}
+
+/**
+ * @brief Reconnaît un disque centré : les cellules actives sont exactement
+ *        celles qui vérifient dx² + dy² <= r² pour un rayon r.
+ */
+bool estDisque(const std::vector<t_Decalage> &decalages, int *rayon) {
+    int r = 0;
+    for (const auto &d: decalages)
+        r = std::max(r, std::max(abs(d.dx), abs(d.dy)));
+    size_t attendues = 0;
+    for (int dy = -r; dy <= r; dy++)
+        for (int dx = -r; dx <= r; dx++)
+            attendues += dx * dx + dy * dy <= r * r;
+    if (decalages.size() != attendues)
+        return false;
+    for (const auto &d: decalages)
+        if (d.dx * d.dx + d.dy * d.dy > r * r)
+            return false;
+    *rayon = r;
+    return true;
+}
@@ -0,0 +1,247 @@
+//
+// Éléments structurants connus à la compilation et noyaux spécialisés sur leur
+// forme.
+//
+// Une forme (t_Croix<R>, t_Carre<R>, t_Losange<R>, t_Disque<R>) est un type : sa
+// liste de cellules actives est calculée par le compilateur, et les noyaux
+// dilatation<Forme>() / erosion<Forme>() déroulent le voisinage en une suite
+// fixe de lectures, sans test par cellule ni cellule blanche parcourue.
+//
+//     dilatation<t_Croix<1> >(imgIn, imgOut, BLACK);
+//
+// appliquerForme() retrouve l'instance d'une forme nommée dont le rayon n'est
+// connu qu'à l'exécution (manifestes de lot.h, banc d'essai). Les éléments
+// construits à l'exécution (createElement) passent par decalagesActifs() et le
+// planificateur.
+//
+
+#ifndef SMP_TP3_ELEMENTS_H
+#define SMP_TP3_ELEMENTS_H
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <utility>
+#include "image.h"
+#include "outils.h"
+
+constexpr int absolu(const int v) { return v < 0 ? -v : v; }
+
+// cellule (dx, dy) d'une forme de rayon r, pour |dx|, |dy| <= r
+constexpr bool dansCroix(const int dx, const int dy, int) { return dx == 0 || dy == 0; }
+constexpr bool dansCarre(int, int, int) { return true; }
+constexpr bool dansLosange(const int dx, const int dy, const int r) { return absolu(dx) + absolu(dy) <= r; }
+constexpr bool dansDisque(const int dx, const int dy, const int r) { return dx * dx + dy * dy <= r * r; }
+
+// croix de rayon R : segments horizontal et vertical de 2R + 1 cellules
+template<int R>
+struct t_Croix {
+    static constexpr int rayon = R;
+    static constexpr bool contient(const int dx, const int dy) { return dansCroix(dx, dy, R); }
+};
+
+// carré plein de côté 2R + 1
+template<int R>
+struct t_Carre {
+    static constexpr int rayon = R;
+    static constexpr bool contient(const int dx, const int dy) { return dansCarre(dx, dy, R); }
+};
+
+// losange (boule de la distance |dx| + |dy|) de rayon R
+template<int R>
+struct t_Losange {
+    static constexpr int rayon = R;
+    static constexpr bool contient(const int dx, const int dy) { return dansLosange(dx, dy, R); }
+};
+
+// disque (boule euclidienne) de rayon R
+template<int R>
+struct t_Disque {
+    static constexpr int rayon = R;
+    static constexpr bool contient(const int dx, const int dy) { return dansDisque(dx, dy, R); }
+};
+
+template<class Forme>
+constexpr int nombreCellules() {
+    int n = 0;
+    for (int dy = -Forme::rayon; dy <= Forme::rayon; dy++)
+        for (int dx = -Forme::rayon; dx <= Forme::rayon; dx++)
+            n += Forme::contient(dx, dy);
+    return n;
+}
+
+template<class Forme>
+constexpr std::array<t_Decalage, nombreCellules<Forme>()> cellulesForme() {
+    std::array<t_Decalage, nombreCellules<Forme>()> cellules{};
+    size_t n = 0;
+    for (int dy = -Forme::rayon; dy <= Forme::rayon; dy++)
+        for (int dx = -Forme::rayon; dx <= Forme::rayon; dx++)
+            if (Forme::contient(dx, dy))
+                cellules[n++] = {dx, dy};
+    return cellules;
+}
+
+// cellules actives de la forme, dans l'ordre de parcours ligne par ligne
+template<class Forme>
+struct t_Motif {
+    static constexpr auto decalages = cellulesForme<Forme>();
+};
+
+// 16 pixels traités ensemble (extensions vectorielles de GCC et Clang)
+typedef t_Pixel t_Vecteur __attribute__((vector_size(16)));
+
+template<class T>
+inline T charger(const t_Pixel *p) {
+    T v;
+    memcpy(&v, p, sizeof v);
+    return v;
+}
+
+template<bool estMaximum, class T>
+inline T combiner(const T a, const T b) {
+    return estMaximum ? (a > b ? a : b) : (a < b ? a : b);
+}
+
+/**
+ * @brief Extremum des pixels recouverts par la forme centrée en @p p (pixel ou
+ *        vecteur de 16 pixels), l'élément étant entièrement dans l'image : le
+ *        pli est déroulé par le compilateur.
+ *
+ * @pre K... vaut 0, ..., nombreCellules<Forme>() - 2 : la première cellule
+ *      initialise l'extremum, le pli combine les suivantes.
+ */
+template<class Forme, bool estMaximum, class T, size_t... K>
+inline T extremumInterieur(const t_Pixel *p, const ptrdiff_t stride, std::index_sequence<K...>) {
+    constexpr auto &d = t_Motif<Forme>::decalages;
+    T m = charger<T>(p + d[0].dy * stride + d[0].dx);
+    ((m = combiner<estMaximum>(m, charger<T>(p + d[K + 1].dy * stride + d[K + 1].dx))), ...);
+    return m;
+}
+
+/**
+ * @brief Même extremum pour un pixel proche du bord : les cellules hors de
+ *        l'image sont ignorées, comme dans dilatation() et erosion().
+ */
+template<class Forme, bool estMaximum>
+inline t_Pixel extremumBord(const t_Image *img, const int x, const int y) {
+    t_Pixel m = estMaximum ? 0 : 255;
+    for (const auto &d: t_Motif<Forme>::decalages) {
+        const int px = x + d.dx, py = y + d.dy;
+        if (px >= 0 && px < img->w && py >= 0 && py < img->h) {
+            m = combiner<estMaximum>(m, img->ligne(py)[px]);
+        }
+    }
+    return m;
+}
+
+/**
+ * @brief Dilatation ou érosion par une forme connue à la compilation : chaque
+ *        pixel dont l'extremum vaut 0 (BLACK) reçoit @p fillColor, les autres
+ *        pixels de @p imgOut sont laissés tels quels.
+ */
+template<class Forme, bool estErosion>
+void morphologieForme(const t_Image *imgIn, t_Image *imgOut, const unsigned int fillColor) {
+    assert(imgIn != nullptr && imgOut != nullptr);
+    assert(imgIn->w == imgOut->w && imgIn->h == imgOut->h);
+    assert(fillColor <= 255);
+
+    constexpr int R = Forme::rayon;
+    constexpr auto sequence = std::make_index_sequence<nombreCellules<Forme>() - 1>();
+    const int w = imgIn->w, h = imgIn->h;
+    const t_Pixel remplissage = (t_Pixel) fillColor;
+    const ptrdiff_t stride = imgIn->stride;
+
+    for (int y = 0; y < h; y++) {
+        t_Pixel *sortie = imgOut->ligne(y);
+        const bool ligneInterieure = y >= R && y < h - R;
+        int x = 0;
+        for (; x < w && (!ligneInterieure || x < R); x++)
+            if (extremumBord<Forme, estErosion>(imgIn, x, y) == 0)
+                sortie[x] = remplissage;
+        if (!ligneInterieure)
+            continue;
+        const t_Pixel *entree = imgIn->ligne(y);
+        const int fin = w - R;
+        const t_Vecteur zero = {}, remplissages = zero + remplissage;
+        for (; x + 16 <= fin; x += 16) {
+            const t_Vecteur m = extremumInterieur<Forme, estErosion, t_Vecteur>(entree + x, stride, sequence);
+            t_Vecteur v = charger<t_Vecteur>(sortie + x);
+            v = m == zero ? remplissages : v;
+            memcpy(sortie + x, &v, sizeof v);
+        }
+        for (; x < fin; x++)
+            if (extremumInterieur<Forme, estErosion, t_Pixel>(entree + x, stride, sequence) == 0)
+                sortie[x] = remplissage;
+        for (; x < w; x++)
+            if (extremumBord<Forme, estErosion>(imgIn, x, y) == 0)
+                sortie[x] = remplissage;
+    }
+}
+
+template<class Forme>
+void dilatation(const t_Image *imgIn, t_Image *imgOut, const unsigned int fillColor = BLACK) {
+    morphologieForme<Forme, false>(imgIn, imgOut, fillColor);
+}
+
+template<class Forme>
+void erosion(const t_Image *imgIn, t_Image *imgOut, const unsigned int fillColor = BLACK) {
+    morphologieForme<Forme, true>(imgIn, imgOut, fillColor);
+}
+
+/**
+ * @brief Construit l'élément structurant équivalent à une forme, pour les
+ *        fonctions qui travaillent sur des éléments construits à l'exécution.
+ *
+ * @return Élément de côté 2R + 1 centré, à libérer avec `delete`.
+ */
+template<class Forme>
+t_ElementStructurant *createElement() {
+    constexpr int cote = 2 * Forme::rayon + 1;
+    t_ElementStructurant *element = createElement(cote, cote, Forme::rayon, Forme::rayon, WHITE);
+    for (const auto &d: t_Motif<Forme>::decalages)
+        element->valeurs[d.dy + Forme::rayon][d.dx + Forme::rayon] = BLACK;
+    return element;
+}
+
+// plus grand rayon pour lequel appliquerForme instancie les formes
+constexpr int RAYON_FORME_MAX = 7;
+
+/**
+ * @brief Appelle @p action(Forme<rayon>()) pour un rayon connu seulement à
+ *        l'exécution : chaque rayon de R à RAYON_FORME_MAX est une instance.
+ *
+ * @return faux (et aucun appel) si le rayon est hors de [R, RAYON_FORME_MAX].
+ */
+template<template<int> class Forme, int R = 0, class Action>
+bool appliquerForme(const int rayon, Action &&action) {
+    if constexpr (R > RAYON_FORME_MAX) {
+        return false;
+    } else {
+        if (rayon == R) {
+            action(Forme<R>());
+            return true;
+        }
+        return appliquerForme<Forme, R + 1>(rayon, std::forward<Action>(action));
+    }
+}
+
+/**
+ * @brief Même appel pour une forme nommée : croix, carre, losange ou disque.
+ *
+ * @return faux si la forme est inconnue ou le rayon hors de [0, RAYON_FORME_MAX].
+ */
+template<class Action>
+bool appliquerForme(const std::string &nom, const int rayon, Action &&action) {
+    if (nom == "croix")
+        return appliquerForme<t_Croix>(rayon, std::forward<Action>(action));
+    if (nom == "carre")
+        return appliquerForme<t_Carre>(rayon, std::forward<Action>(action));
+    if (nom == "losange")
+        return appliquerForme<t_Losange>(rayon, std::forward<Action>(action));
+    if (nom == "disque")
+        return appliquerForme<t_Disque>(rayon, std::forward<Action>(action));
+    return false;
+}
+
+#endif //SMP_TP3_ELEMENTS_H
@@ -0,0 +1,129 @@
+//
+// Ouverture et fermeture en un seul passage : les lignes de l'image
+// intermédiaire transitent par un tampon circulaire de la hauteur de
+// l'élément structurant au lieu d'une image complète. Les chapeaux
+// haut-de-forme (gradients.cpp) y ajoutent la différence avec l'entrée.
+//
+
+#include "flux.h"
+#include "noyaux.h"
+#include "parallele.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+/*
+ * La ligne y de la sortie dépend des lignes intermédiaires y + dyMin à y + dyMax,
+ * et la ligne intermédiaire r des lignes d'entrée r + dyMin à r + dyMax. Les
+ * lignes de sortie sont produites dans l'ordre ; avant la ligne y, les lignes
+ * intermédiaires manquantes jusqu'à y + dyMax sont calculées et rangées dans le
+ * tampon à l'emplacement r modulo (dyMax - dyMin + 1). Le tampon contient alors
+ * exactement les lignes dont la ligne y a besoin.
+ *
+ * Chaque bande de lignes (voir parallele.h) a son propre tampon et recalcule les
+ * lignes intermédiaires de son halo.
+ */
+
+/**
+ * @brief Calcule la seconde opération sur les lignes [b.y0, b.y1), à partir des
+ *        lignes intermédiaires produites par la première au fil de l'eau.
+ *
+ * Comme dans ouverture() et fermeture(), l'image intermédiaire est blanche sauf
+ * là où la première opération a placé @p fillColor. Si @p chapeau est vrai, la
+ * ligne de sortie reçoit l'écart absolu entre la ligne d'entrée et le résultat
+ * binaire (0 ou 255) de la seconde opération.
+ */
+static void enchainerBande(const t_Image *imgIn, t_Image *imgOut, const std::vector<t_Decalage> &decalages,
+                           const bool premiereEstErosion, const t_Pixel fillColor, const bool chapeau,
+                           const int dyMin, const int dyMax, const t_Bande &b) {
+    const int w = imgIn->w, h = imgIn->h;
+    const int hauteur = dyMax - dyMin + 1;
+    std::vector<t_Pixel> tampon((size_t) hauteur * w);
+    std::vector<t_Pixel> acc(w);
+    std::vector<const t_Pixel *> lignes(hauteur);
+    auto emplacement = [&](const int r) { return tampon.data() + (size_t) (r % hauteur) * w; };
+
+    int suivante = std::max(0, b.y0 + dyMin);
+    for (int y = b.y0; y < b.y1; y++) {
+        for (const int derniere = std::min(h - 1, y + dyMax); suivante <= derniere; suivante++) {
+            t_Pixel *intermediaire = emplacement(suivante);
+            for (int dy = dyMin; dy <= dyMax; dy++)
+                lignes[dy - dyMin] = suivante + dy >= 0 && suivante + dy < h ? imgIn->ligne(suivante + dy) : nullptr;
+            extremumDepuisLignes(lignes.data(), dyMin, w, decalages, premiereEstErosion, acc.data());
+            memset(intermediaire, WHITE, w);
+            noyaux().remplirSiNul(intermediaire, acc.data(), w, fillColor);
+        }
+
+        for (int dy = dyMin; dy <= dyMax; dy++)
+            lignes[dy - dyMin] = y + dy >= 0 && y + dy < h ? emplacement(y + dy) : nullptr;
+        extremumDepuisLignes(lignes.data(), dyMin, w, decalages, !premiereEstErosion, acc.data());
+        if (chapeau) {
+            noyaux().seuillerLigne(acc.data(), acc.data(), w, 1);
+            noyaux().differenceLigne(imgOut->ligne(y), imgIn->ligne(y), acc.data(), w, 0);
+        } else {
+            noyaux().remplirSiNul(imgOut->ligne(y), acc.data(), w, fillColor);
+        }
+    }
+}
+
+static void enchainer(const t_Image *imgIn, t_Image *imgOut, const std::vector<t_Decalage> &decalages,
+                      const bool premiereEstErosion, const unsigned int fillColor, const bool chapeau = false) {
+    assert(imgIn != imgOut);
+    assert(imgIn->w == imgOut->w && imgIn->h == imgOut->h);
+    assert(fillColor <= 255);
+
+    int dyMin = 0, dyMax = 0;
+    for (const auto &d: decalages) {
+        dyMin = std::min(dyMin, d.dy);
+        dyMax = std::max(dyMax, d.dy);
+    }
+    // la sortie lit les lignes intermédiaires [y + dyMin, y + dyMax], qui lisent
+    // à leur tour l'entrée sur la même étendue : le halo est doublé
+    pourBandes(imgIn->h, -2 * dyMin, 2 * dyMax, [&](const t_Bande &b) {
+        enchainerBande(imgIn, imgOut, decalages, premiereEstErosion, (t_Pixel) fillColor, chapeau, dyMin, dyMax,
+                       b);
+    });
+}
+
+/**
+ * @brief Ouverture (érosion puis dilatation) sans image intermédiaire.
+ *
+ * Même résultat que ouverture() avec l'élément dont @p decalages sont les
+ * cellules actives ; les pixels de @p imgOut non retenus ne sont pas modifiés.
+ *
+ * @pre imgIn != imgOut, de mêmes dimensions
+ * @pre 0 <= fillColor <= 255
+ */
+void ouvertureFlux(const t_Image *imgIn, t_Image *imgOut, const std::vector<t_Decalage> &decalages,
+                   const unsigned int fillColor) {
+    enchainer(imgIn, imgOut, decalages, true, fillColor);
+}
+
+/**
+ * @brief Fermeture (dilatation puis érosion) sans image intermédiaire.
+ *
+ * Même résultat que fermeture() avec l'élément dont @p decalages sont les
+ * cellules actives ; les pixels de @p imgOut non retenus ne sont pas modifiés.
+ *
+ * @pre imgIn != imgOut, de mêmes dimensions
+ * @pre 0 <= fillColor <= 255
+ */
+void fermetureFlux(const t_Image *imgIn, t_Image *imgOut, const std::vector<t_Decalage> &decalages,
+                   const unsigned int fillColor) {
+    enchainer(imgIn, imgOut, decalages, false, fillColor);
+}
+
+/**
+ * @brief Chapeau haut-de-forme sans image intermédiaire : écart absolu entre
+ *        l'image et son ouverture (chapeau blanc) ou sa fermeture (chapeau noir).
+ *
+ * Même résultat que difference() entre @p imgIn et ouverture() (ou fermeture())
+ * d'une image blanche avec fillColor = BLACK ; tous les pixels de @p imgOut
+ * sont écrits.
+ *
+ * @pre imgIn != imgOut, de mêmes dimensions
+ */
+void chapeauFlux(const t_Image *imgIn, t_Image *imgOut, const std::vector<t_Decalage> &decalages,
+                 const bool blanc) {
+    enchainer(imgIn, imgOut, decalages, blanc, BLACK, true);
+}
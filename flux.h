@@ -0,0 +1,19 @@
+//
+// Ouverture et fermeture en un seul passage : les lignes de l'image
+// intermédiaire transitent par un tampon circulaire de la hauteur de
+// l'élément structurant au lieu d'une image complète. Les chapeaux
+// haut-de-forme (gradients.cpp) y ajoutent la différence avec l'entrée.
+//
+
+#ifndef SMP_TP3_FLUX_H
+#define SMP_TP3_FLUX_H
+#include <vector>
+#include "image.h"
+#include "outils.h"
+
+void ouvertureFlux(const t_Image *imgIn, t_Image *imgOut, const std::vector<t_Decalage> &decalages,
+                   unsigned int fillColor);
+void fermetureFlux(const t_Image *imgIn, t_Image *imgOut, const std::vector<t_Decalage> &decalages,
+                   unsigned int fillColor);
+void chapeauFlux(const t_Image *imgIn, t_Image *imgOut, const std::vector<t_Decalage> &decalages, bool blanc);
+#endif //SMP_TP3_FLUX_H
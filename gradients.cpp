@@ -0,0 +1,249 @@
+//
+// Gradients morphologiques, chapeaux haut-de-forme et contour en une passe.
+//
+
+#include "outils.h"
+#include "flux.h"
+#include "instrumentation.h"
+#include "noyaux.h"
+#include "parallele.h"
+#include "planificateur.h"
+#include "reserve.h"
+#include <algorithm>
+#include <cassert>
+
+/*
+ * Ces opérateurs valent une différence entre l'image et sa dilatation, son
+ * érosion, son ouverture ou sa fermeture, calculées comme dans outils.cpp sur
+ * une image blanche avec fillColor = BLACK (pixels à 0 ou 255). Pour un élément
+ * traité cellule par cellule, chaque ligne de sortie est produite directement à
+ * partir des lignes d'entrée voisines : le minimum (dilatation) et le maximum
+ * (érosion) sont accumulés dans deux tampons d'une ligne, en une seule lecture
+ * de chaque ligne voisine (voir extremumsDepuisLignes()), puis combinés avec la
+ * ligne d'entrée. Aucune image intermédiaire n'est allouée et l'image d'entrée
+ * n'est lue qu'une fois. Les autres éléments (grands rectangles, disques,
+ * unions...) passent par les opérateurs complets et des images empruntées.
+ */
+
+// opérations calculées ligne à ligne
+typedef enum {
+    LIGNE_GRADIENT_INTERNE,
+    LIGNE_GRADIENT_EXTERNE,
+    LIGNE_GRADIENT_SYMETRIQUE,
+    LIGNE_CONTOUR
+} t_OperationLigne;
+
+static t_OperationLigne operationGradient(const t_TypeGradient type) {
+    switch (type) {
+        case GRADIENT_INTERNE:
+            return LIGNE_GRADIENT_INTERNE;
+        case GRADIENT_EXTERNE:
+            return LIGNE_GRADIENT_EXTERNE;
+        case GRADIENT_SYMETRIQUE:
+        default:
+            return LIGNE_GRADIENT_SYMETRIQUE;
+    }
+}
+
+/**
+ * @brief Ligne de sortie à partir de la ligne d'entrée et du minimum (@p dilate)
+ *        et du maximum (@p erode) des pixels voisins.
+ *
+ * Les extrema sont ramenés sur place à 0 ou 255 (dilatation ou érosion d'une
+ * image blanche) ; seul celui dont l'opération a besoin est lu.
+ */
+static void combinerLigne(const t_OperationLigne operation, t_Pixel *dst, const t_Pixel *src, t_Pixel *dilate,
+                          t_Pixel *erode, const int w) {
+    const t_Noyaux &k = noyaux();
+    switch (operation) {
+        case LIGNE_GRADIENT_INTERNE:
+            k.seuillerLigne(erode, erode, w, 1);
+            k.differenceLigne(dst, src, erode, w, 0);
+            break;
+        case LIGNE_GRADIENT_EXTERNE:
+            k.seuillerLigne(dilate, dilate, w, 1);
+            k.differenceLigne(dst, dilate, src, w, 0);
+            break;
+        case LIGNE_GRADIENT_SYMETRIQUE:
+            k.seuillerLigne(dilate, dilate, w, 1);
+            k.seuillerLigne(erode, erode, w, 1);
+            k.differenceLigne(dst, dilate, erode, w, 0);
+            break;
+        case LIGNE_CONTOUR:
+            // pixels noirs, sauf ceux dont l'érosion est noire
+            k.seuillerLigne(dst, src, w, 1);
+            k.remplirSiNul(dst, erode, w, WHITE);
+            break;
+    }
+}
+
+static void combinerBande(const t_Image *imgIn, t_Image *imgOut, const std::vector<t_Decalage> &decalages,
+                          const t_OperationLigne operation, const int dyMin, const int dyMax, const t_Bande &b) {
+    const int w = imgIn->w, h = imgIn->h;
+    std::vector<t_Pixel> dilate(w), erode(w);
+    std::vector<const t_Pixel *> lignes(dyMax - dyMin + 1);
+
+    for (int y = b.y0; y < b.y1; y++) {
+        for (int dy = dyMin; dy <= dyMax; dy++)
+            lignes[dy - dyMin] = y + dy >= 0 && y + dy < h ? imgIn->ligne(y + dy) : nullptr;
+        if (operation == LIGNE_GRADIENT_SYMETRIQUE)
+            extremumsDepuisLignes(lignes.data(), dyMin, w, decalages, dilate.data(), erode.data());
+        else if (operation == LIGNE_GRADIENT_EXTERNE)
+            extremumDepuisLignes(lignes.data(), dyMin, w, decalages, false, dilate.data());
+        else
+            extremumDepuisLignes(lignes.data(), dyMin, w, decalages, true, erode.data());
+        combinerLigne(operation, imgOut->ligne(y), imgIn->ligne(y), dilate.data(), erode.data(), w);
+    }
+}
+
+/**
+ * @brief Applique @p operation à toute l'image, en une passe si l'élément est
+ *        traité cellule par cellule, sinon à partir des images complètes de la
+ *        dilatation et de l'érosion.
+ */
+static void appliquer(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *element,
+                      const t_OperationLigne operation) {
+    assert(imgIn != imgOut && "L'image de sortie doit être distincte de l'image d'entrée.");
+    assert(imgOut->w == imgIn->w && "La largeur de l'image d'entrée et de sortie doivent être égale.");
+    assert(imgOut->h == imgIn->h && "La hauteur de l'image d'entrée et de sortie doivent être égale.");
+    assert(element->h == element->w && "L'élément structurant doit être carrée.");
+    assert(element->h % 2 == 1 && "La taille de l'élément structurant doit être impaire.");
+
+    if (noyaux().jeu != JEU_SCALAIRE) {
+        const t_Plan plan = planifier(decalagesActifs(element));
+        if (plan.type == ETAPE_DIRECTE) {
+            int dyMin = 0, dyMax = 0;
+            for (const auto &d: plan.decalages) {
+                dyMin = std::min(dyMin, d.dy);
+                dyMax = std::max(dyMax, d.dy);
+            }
+            pourBandes(imgIn->h, -dyMin, dyMax, [&](const t_Bande &b) {
+                combinerBande(imgIn, imgOut, plan.decalages, operation, dyMin, dyMax, b);
+            });
+            return;
+        }
+    }
+
+    const bool avecDilatation = operation == LIGNE_GRADIENT_EXTERNE || operation == LIGNE_GRADIENT_SYMETRIQUE;
+    const bool avecErosion = operation != LIGNE_GRADIENT_EXTERNE;
+    t_ImageEmpruntee dilate(avecDilatation ? emprunterImage(imgIn->h, imgIn->w, WHITE) : nullptr);
+    t_ImageEmpruntee erode(avecErosion ? emprunterImage(imgIn->h, imgIn->w, WHITE) : nullptr);
+    if (avecDilatation)
+        dilatation(imgIn, dilate.get(), element, BLACK);
+    if (avecErosion)
+        erosion(imgIn, erode.get(), element, BLACK);
+    pourBandes(imgIn->h, 0, 0, [&](const t_Bande &b) {
+        for (int y = b.y0; y < b.y1; y++)
+            combinerLigne(operation, imgOut->ligne(y), imgIn->ligne(y), avecDilatation ? dilate->ligne(y) : nullptr,
+                          avecErosion ? erode->ligne(y) : nullptr, imgIn->w);
+    });
+}
+
+/**
+ * @brief Gradient morphologique d'une image : écart absolu entre deux des
+ *        images dilatée, d'origine et érodée.
+ *
+ * Même résultat que difference() entre les images correspondantes, la
+ * dilatation et l'érosion étant faites sur des images blanches avec
+ * fillColor = BLACK, mais en une passe et sans image intermédiaire pour un
+ * élément traité cellule par cellule. Les pixels du bord des objets valent
+ * 255 (pour une image binaire), les autres 0.
+ *
+ * @param imgIn   Image d'entrée, non modifiée.
+ * @param imgOut  Image de sortie de mêmes dimensions, entièrement écrite.
+ * @param element Élément structurant carré de taille impaire.
+ * @param type    GRADIENT_INTERNE (image - érosion), GRADIENT_EXTERNE
+ *                (dilatation - image) ou GRADIENT_SYMETRIQUE (dilatation - érosion).
+ *
+ * @pre imgIn != imgOut
+ * @pre imgOut->w == imgIn->w
+ * @pre imgOut->h == imgIn->h
+ * @pre element->w == element->h
+ * @pre element->w % 2 == 1
+ */
+void gradient(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *element, const t_TypeGradient type) {
+    INSTRUMENTER("gradient");
+    COMPTER_PIXELS((size_t) imgIn->w * imgIn->h);
+    COMPTER_LECTURE((size_t) imgIn->w * imgIn->h);
+    appliquer(imgIn, imgOut, element, operationGradient(type));
+}
+
+/**
+ * @brief Contour des objets (noirs) d'une image binaire : pixels noirs dont
+ *        l'érosion par @p element est blanche.
+ *
+ * Les pixels du contour sont noirs, tous les autres blancs ; pour une image
+ * binaire, c'est l'inverse du gradient interne. Calculé en une passe comme
+ * gradient().
+ *
+ * @pre imgIn != imgOut, de mêmes dimensions
+ * @pre element->w == element->h, impair
+ */
+void contour(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *element) {
+    INSTRUMENTER("contour");
+    COMPTER_PIXELS((size_t) imgIn->w * imgIn->h);
+    COMPTER_LECTURE((size_t) imgIn->w * imgIn->h);
+    appliquer(imgIn, imgOut, element, LIGNE_CONTOUR);
+}
+
+/**
+ * @brief Chapeau haut-de-forme « blanc » : écart absolu entre l'image et son
+ *        ouverture.
+ *
+ * Les objets étant noirs, il fait ressortir (à 255) les détails noirs plus
+ * petits que l'élément, que l'ouverture supprime. Même résultat que
+ * difference(imgIn, ouverture), l'ouverture étant faite sur une image blanche
+ * avec fillColor = BLACK.
+ *
+ * @note Pour un élément traité cellule par cellule, l'érosion, la dilatation et
+ *       la différence sont enchaînées ligne à ligne (voir flux.h) ; sinon
+ *       l'ouverture est calculée dans une image empruntée à la réserve.
+ *
+ * @pre imgIn != imgOut, de mêmes dimensions
+ * @pre element->w == element->h, impair
+ */
+void chapeauBlanc(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *element) {
+    INSTRUMENTER("chapeauBlanc");
+    COMPTER_PIXELS((size_t) imgIn->w * imgIn->h);
+    COMPTER_LECTURE((size_t) imgIn->w * imgIn->h);
+    assert(imgIn != imgOut && "L'image de sortie doit être distincte de l'image d'entrée.");
+
+    if (noyaux().jeu != JEU_SCALAIRE) {
+        const t_Plan plan = planifier(decalagesActifs(element));
+        if (plan.type == ETAPE_DIRECTE) {
+            chapeauFlux(imgIn, imgOut, plan.decalages, true);
+            return;
+        }
+    }
+    t_ImageEmpruntee ouverte(emprunterImage(imgIn->h, imgIn->w, WHITE));
+    ouverture(imgIn, ouverte.get(), element, BLACK);
+    difference(imgIn, ouverte.get(), imgOut);
+}
+
+/**
+ * @brief Chapeau haut-de-forme « noir » : écart absolu entre la fermeture de
+ *        l'image et l'image.
+ *
+ * Fait ressortir (à 255) les trous et creux blancs plus petits que l'élément,
+ * que la fermeture comble. Calculé comme chapeauBlanc().
+ *
+ * @pre imgIn != imgOut, de mêmes dimensions
+ * @pre element->w == element->h, impair
+ */
+void chapeauNoir(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *element) {
+    INSTRUMENTER("chapeauNoir");
+    COMPTER_PIXELS((size_t) imgIn->w * imgIn->h);
+    COMPTER_LECTURE((size_t) imgIn->w * imgIn->h);
+    assert(imgIn != imgOut && "L'image de sortie doit être distincte de l'image d'entrée.");
+
+    if (noyaux().jeu != JEU_SCALAIRE) {
+        const t_Plan plan = planifier(decalagesActifs(element));
+        if (plan.type == ETAPE_DIRECTE) {
+            chapeauFlux(imgIn, imgOut, plan.decalages, false);
+            return;
+        }
+    }
+    t_ImageEmpruntee fermee(emprunterImage(imgIn->h, imgIn->w, WHITE));
+    fermeture(imgIn, fermee.get(), element, BLACK);
+    difference(fermee.get(), imgIn, imgOut);
+}
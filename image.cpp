@@ -0,0 +1,117 @@
+/*********************************************
+Fichier : image.cpp
+But : gestion de la mémoire des images t_Image
+(allocation alignée, réallocation, libération)
+*********************************************/
+
+#include <new>
+#include <utility>
+
+#include "image.h"
+
+//arrondit la largeur au multiple de ALIGNEMENT supérieur
+static int strideAligne(int w)
+{
+  return (w + ALIGNEMENT - 1) / ALIGNEMENT * ALIGNEMENT;
+}
+
+t_Image::t_Image()
+  : w(0), h(0), stride(0), pixels(nullptr), capacite(0),
+    blocExterne(nullptr), tailleExterne(0), liberation(nullptr)
+{
+}
+
+t_Image::t_Image(int h, int w)
+  : t_Image()
+{
+  allouer(h, w);
+}
+
+t_Image::~t_Image()
+{
+  liberer();
+}
+
+t_Image::t_Image(t_Image && autre) noexcept
+  : w(autre.w), h(autre.h), stride(autre.stride),
+    pixels(autre.pixels), capacite(autre.capacite),
+    blocExterne(autre.blocExterne), tailleExterne(autre.tailleExterne),
+    liberation(autre.liberation)
+{
+  autre.w = autre.h = autre.stride = 0;
+  autre.pixels = nullptr;
+  autre.capacite = 0;
+  autre.blocExterne = nullptr;
+  autre.tailleExterne = 0;
+  autre.liberation = nullptr;
+}
+
+t_Image & t_Image::operator=(t_Image && autre) noexcept
+{
+  if (this != &autre)
+    {
+      liberer();
+      w = std::exchange(autre.w, 0);
+      h = std::exchange(autre.h, 0);
+      stride = std::exchange(autre.stride, 0);
+      pixels = std::exchange(autre.pixels, nullptr);
+      capacite = std::exchange(autre.capacite, 0);
+      blocExterne = std::exchange(autre.blocExterne, nullptr);
+      tailleExterne = std::exchange(autre.tailleExterne, 0);
+      liberation = std::exchange(autre.liberation, nullptr);
+    }
+  return *this;
+}
+
+void t_Image::allouer(int h, int w)
+{
+  const int nouveauStride = strideAligne(w);
+  const size_t taille = (size_t) h * nouveauStride;
+
+  if (taille > capacite || liberation != nullptr)
+    {
+      liberer();
+      pixels = static_cast<t_Pixel *>(::operator new[](taille, std::align_val_t(ALIGNEMENT)));
+      capacite = taille;
+    }
+  this->w = w;
+  this->h = h;
+  stride = nouveauStride;
+}
+
+void t_Image::reserver(size_t taille)
+{
+  if (taille > capacite || liberation != nullptr)
+    {
+      liberer();
+      pixels = static_cast<t_Pixel *>(::operator new[](taille, std::align_val_t(ALIGNEMENT)));
+      capacite = taille;
+    }
+  w = h = stride = 0;
+}
+
+void t_Image::adopter(t_Pixel * pixels, int h, int w, int stride,
+                      void * bloc, size_t taille, t_Liberation liberation)
+{
+  liberer();
+  this->pixels = pixels;
+  this->w = w;
+  this->h = h;
+  this->stride = stride;
+  blocExterne = bloc;
+  tailleExterne = taille;
+  this->liberation = liberation;
+}
+
+void t_Image::liberer()
+{
+  if (liberation != nullptr)
+    liberation(blocExterne, tailleExterne);
+  else if (pixels != nullptr)
+    ::operator delete[](pixels, std::align_val_t(ALIGNEMENT));
+  pixels = nullptr;
+  capacite = 0;
+  blocExterne = nullptr;
+  tailleExterne = 0;
+  liberation = nullptr;
+}
@@ -11,19 +11,69 @@ pour représenter une image au format PGM
 #ifndef __secsmp_image
 #define __secsmp_image 
 
-//on fixe la taille maximale des images
-const int TMAX = 800;
+#include <cstddef>
 
-//on définit un type matrice d'entiers 
-//pour rentrer les niveaux de gris des pixels de l'image 
-typedef unsigned int t_MatEnt[TMAX][TMAX]; 
+//alignement (en octets) du début de chaque ligne d'une image :
+//une ligne de cache
+const int ALIGNEMENT = 64;
+
+//un niveau de gris est codé sur 8 bits
+typedef unsigned char t_Pixel;
+
+//fonction chargée de rendre un bloc de pixels que l'image ne possède pas
+//(projection mémoire d'un fichier, ...)
+typedef void (*t_Liberation)(void * bloc, size_t taille);
 
 //on définit la structure de données pour représenter une image
+//les pixels sont rangés ligne par ligne dans un seul bloc contigu ;
+//chaque ligne commence sur une frontière de ALIGNEMENT octets et
+//occupe stride octets (stride >= w). Le bloc appartient à l'image
+//et est libéré par son destructeur.
+//Une image peut aussi être une vue sur un bloc externe (voir adopter) :
+//ses lignes ne sont alors pas forcément alignées.
 struct t_Image
 {
 	int w; //largeur de l'image
     int h; //hauteur de l'image
-	t_MatEnt im; //tableau des niveaux de gris de l'image
+	int stride; //nombre d'octets séparant deux lignes consécutives
+	t_Pixel * pixels; //premier pixel de la première ligne
+
+	t_Image();
+	t_Image(int h, int w);
+	~t_Image();
+
+	t_Image(const t_Image &) = delete;
+	t_Image & operator=(const t_Image &) = delete;
+	t_Image(t_Image && autre) noexcept;
+	t_Image & operator=(t_Image && autre) noexcept;
+
+	//donne à l'image les dimensions h x w ; le contenu des pixels
+	//n'est pas initialisé. Le bloc courant est réutilisé s'il est
+	//assez grand.
+	void allouer(int h, int w);
+
+	//donne à l'image un bloc d'au moins taille octets, que les appels
+	//suivants à allouer réutiliseront ; l'image est alors vide (0 x 0)
+	void reserver(size_t taille);
+
+	//taille du bloc alloué par l'image (0 si c'est une vue)
+	size_t capaciteAllouee() const { return liberation == nullptr ? capacite : 0; }
+
+	//fait de l'image une vue sur des pixels déjà présents en mémoire.
+	//Le bloc [bloc, bloc + taille) qui les contient sera rendu par
+	//liberation(bloc, taille) lorsque l'image n'en aura plus besoin.
+	void adopter(t_Pixel * pixels, int h, int w, int stride,
+	             void * bloc, size_t taille, t_Liberation liberation);
+
+	t_Pixel * ligne(int i) { return pixels + (size_t) i * stride; }
+	const t_Pixel * ligne(int i) const { return pixels + (size_t) i * stride; }
+
+private:
+	size_t capacite; //taille en octets du bloc alloué par l'image
+	void * blocExterne; //bloc adopté (0 si l'image possède ses pixels)
+	size_t tailleExterne;
+	t_Liberation liberation;
+	void liberer();
 };
 
 #endif
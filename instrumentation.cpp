@@ -0,0 +1,81 @@
+//
+// Registre des compteurs d'instrumentation et bilan de fin de programme.
+//
+
+#include "instrumentation.h"
+
+#ifdef SMP_INSTRUMENTATION
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+
+// compteurs de toutes les fonctions instrumentées, dans l'ordre de leur premier
+// appel ; le bilan est produit à la destruction du registre
+struct t_Registre {
+    std::mutex verrou;
+    std::deque<t_Compteur> compteurs;
+
+    ~t_Registre();
+};
+
+static t_Registre &registre() {
+    static t_Registre instance;
+    return instance;
+}
+
+/**
+ * @brief Compteur de la fonction @p nom, créé au premier appel.
+ *
+ * Chaque fonction instrumentée le demande une seule fois (voir INSTRUMENTER) ;
+ * l'adresse du compteur reste valide jusqu'à la fin du programme.
+ */
+t_Compteur *compteurInstrumentation(const char *nom) {
+    t_Registre &r = registre();
+    std::lock_guard<std::mutex> garde(r.verrou);
+    r.compteurs.emplace_back();
+    r.compteurs.back().nom = nom;
+    return &r.compteurs.back();
+}
+
+static void afficherBilan(const std::deque<t_Compteur> &compteurs) {
+    fprintf(stderr, "=== Instrumentation (temps inclusif) ===\n");
+    fprintf(stderr, "%-22s %10s %12s %12s %10s %14s %14s\n", "fonction", "appels", "total ms", "moyenne us",
+            "Mpx/s", "alloués Mo", "lus Mo");
+    for (const auto &c: compteurs) {
+        const double ms = c.nanosecondes / 1e6;
+        const double appels = (double) c.appels;
+        fprintf(stderr, "%-22s %10llu %12.3f %12.3f %10.1f %14.3f %14.3f\n", c.nom,
+                (unsigned long long) c.appels, ms, appels > 0 ? ms * 1000 / appels : 0.0,
+                ms > 0 ? c.pixels / 1e6 / (ms / 1000) : 0.0, c.octetsAlloues / 1e6, c.octetsLus / 1e6);
+    }
+}
+
+static void ecrireBilanJson(const std::deque<t_Compteur> &compteurs, const char *nomFichier) {
+    FILE *fichier = fopen(nomFichier, "w");
+    if (fichier == nullptr) {
+        fprintf(stderr, "%s: impossible d'écrire le bilan d'instrumentation\n", nomFichier);
+        return;
+    }
+    fprintf(fichier, "[\n");
+    for (size_t i = 0; i < compteurs.size(); i++) {
+        const t_Compteur &c = compteurs[i];
+        fprintf(fichier,
+                "  {\"fonction\": \"%s\", \"appels\": %llu, \"nanosecondes\": %llu, \"pixels\": %llu, "
+                "\"octets_alloues\": %llu, \"octets_lus\": %llu}%s\n",
+                c.nom, (unsigned long long) c.appels, (unsigned long long) c.nanosecondes,
+                (unsigned long long) c.pixels, (unsigned long long) c.octetsAlloues,
+                (unsigned long long) c.octetsLus, i + 1 < compteurs.size() ? "," : "");
+    }
+    fprintf(fichier, "]\n");
+    fclose(fichier);
+}
+
+t_Registre::~t_Registre() {
+    if (compteurs.empty())
+        return;
+    afficherBilan(compteurs);
+    const char *nomFichier = getenv("SMP_INSTRUMENTATION_JSON");
+    ecrireBilanJson(compteurs, nomFichier != nullptr && *nomFichier != '\0' ? nomFichier : "instrumentation.json");
+}
+#endif
@@ -0,0 +1,77 @@
+//
+// Instrumentation des fonctions de chargesauve.cpp et de outils.cpp : nombre
+// d'appels, temps écoulé, pixels traités, octets alloués et lus.
+//
+// Elle n'existe que si SMP_INSTRUMENTATION est défini à la compilation
+// (make INSTRUMENTATION=1, ou cmake -DSMP_INSTRUMENTATION=ON) ; sinon les
+// macros ne produisent aucun code et leurs arguments ne sont pas évalués.
+// Le bilan est affiché sur la sortie d'erreur à la fin du programme et
+// enregistré en JSON dans le fichier nommé par la variable d'environnement
+// SMP_INSTRUMENTATION_JSON (instrumentation.json par défaut).
+//
+// Exemple :
+//
+//     void seuillage(t_Image *image, unsigned int s) {
+//         INSTRUMENTER("seuillage");
+//         COMPTER_PIXELS((size_t) image->w * image->h);
+//         ...
+//     }
+//
+// Le temps d'une fonction inclut celui des fonctions instrumentées qu'elle
+// appelle (ouverture compte aussi son érosion et sa dilatation).
+//
+
+#ifndef SMP_TP3_INSTRUMENTATION_H
+#define SMP_TP3_INSTRUMENTATION_H
+
+#ifdef SMP_INSTRUMENTATION
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// mesures cumulées d'une fonction, tous threads confondus
+struct t_Compteur {
+    const char *nom;
+    std::atomic<uint64_t> appels{0}, nanosecondes{0}, pixels{0}, octetsAlloues{0}, octetsLus{0};
+};
+
+t_Compteur *compteurInstrumentation(const char *nom);
+
+// compte un appel et ajoute au compteur le temps écoulé jusqu'à la fin du bloc
+class t_Chronometre {
+public:
+    explicit t_Chronometre(t_Compteur *compteur)
+        : compteur(compteur), debut(std::chrono::steady_clock::now()) {
+    }
+
+    ~t_Chronometre() {
+        const auto duree = std::chrono::steady_clock::now() - debut;
+        compteur->appels.fetch_add(1, std::memory_order_relaxed);
+        compteur->nanosecondes.fetch_add(
+                (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(duree).count(),
+                std::memory_order_relaxed);
+    }
+
+    t_Chronometre(const t_Chronometre &) = delete;
+    t_Chronometre &operator=(const t_Chronometre &) = delete;
+
+private:
+    t_Compteur *compteur;
+    std::chrono::steady_clock::time_point debut;
+};
+
+#define INSTRUMENTER(nom) \
+    static t_Compteur *const compteurInstrumente = compteurInstrumentation(nom); \
+    const t_Chronometre chronometreInstrumente(compteurInstrumente)
+#define COMPTER_PIXELS(n) compteurInstrumente->pixels.fetch_add((uint64_t) (n), std::memory_order_relaxed)
+#define COMPTER_ALLOCATION(octets) \
+    compteurInstrumente->octetsAlloues.fetch_add((uint64_t) (octets), std::memory_order_relaxed)
+#define COMPTER_LECTURE(octets) \
+    compteurInstrumente->octetsLus.fetch_add((uint64_t) (octets), std::memory_order_relaxed)
+#else
+#define INSTRUMENTER(nom) do {} while (0)
+#define COMPTER_PIXELS(n) do {} while (0)
+#define COMPTER_ALLOCATION(octets) do {} while (0)
+#define COMPTER_LECTURE(octets) do {} while (0)
+#endif
+#endif //SMP_TP3_INSTRUMENTATION_H
@@ -0,0 +1,344 @@
+//
+// Traitement par lot : une même chaîne d'opérateurs appliquée à une liste
+// d'images décrite dans un manifeste, les images étant traitées en parallèle.
+//
+
+#include "lot.h"
+#include "elements.h"
+#include "parallele.h"
+#include "pipeline.h"
+#include "reserve.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+/**
+ * @brief Construit un élément centré de rayon @p rayon dont les cellules
+ *        actives sont celles de la forme nommée (voir elements.h) : croix,
+ *        carre, losange ou disque.
+ *
+ * Jusqu'à RAYON_FORME_MAX, les cellules sont celles calculées à la compilation
+ * (cellulesForme) ; au-delà, elles sont énumérées avec les mêmes prédicats.
+ *
+ * @return Élément alloué dynamiquement, à libérer avec `delete`.
+ */
+t_ElementStructurant *elementForme(const std::string &forme, const int rayon) {
+    t_ElementStructurant *element = nullptr;
+    if (appliquerForme(forme, rayon, [&](auto motif) { element = createElement<decltype(motif)>(); }))
+        return element;
+
+    const int cote = 2 * rayon + 1;
+    bool (*const dans)(int, int, int) = forme == "croix"     ? dansCroix
+                                        : forme == "losange" ? dansLosange
+                                        : forme == "disque"  ? dansDisque
+                                                             : dansCarre;
+    element = createElement(cote, cote, rayon, rayon, WHITE);
+    for (int dy = -rayon; dy <= rayon; dy++)
+        for (int dx = -rayon; dx <= rayon; dx++)
+            if (dans(dx, dy, rayon))
+                element->valeurs[dy + rayon][dx + rayon] = BLACK;
+    return element;
+}
+
+/**
+ * @brief Construit un élément à partir de ses lignes « 010/111/010 ».
+ * @return nullptr si le motif n'est pas un rectangle de 0 et de 1 de côtés impairs.
+ */
+static t_ElementStructurant *elementMotif(const std::string &motif) {
+    std::vector<std::string> lignes;
+    std::stringstream flux(motif);
+    for (std::string ligne; std::getline(flux, ligne, '/');)
+        lignes.push_back(ligne);
+    if (lignes.empty() || lignes[0].empty() || lignes.size() % 2 == 0 || lignes[0].size() != lignes.size())
+        return nullptr;
+
+    const int cote = (int) lignes.size();
+    t_ElementStructurant *element = createElement(cote, cote, cote / 2, cote / 2, WHITE);
+    for (int i = 0; i < cote; i++) {
+        if ((int) lignes[i].size() != cote || lignes[i].find_first_not_of("01") != std::string::npos) {
+            delete element;
+            return nullptr;
+        }
+        for (int j = 0; j < cote; j++)
+            if (lignes[i][j] == '1')
+                element->valeurs[i][j] = BLACK;
+    }
+    return element;
+}
+
+/**
+ * @brief Lit un manifeste de lot (voir lot.h pour son format).
+ *
+ * @param nomManifeste Fichier à lire.
+ * @param lot          Reçoit la description du lot.
+ * @param erreur       En cas d'échec, « fichier:ligne: message ».
+ * @return vrai si le manifeste est valide.
+ */
+bool lireManifeste(const std::string &nomManifeste, t_Lot &lot, std::string &erreur) {
+    std::ifstream fichier(nomManifeste);
+    if (!fichier) {
+        erreur = nomManifeste + ": impossible de lire le fichier";
+        return false;
+    }
+
+    int numero = 0;
+    auto echec = [&](const std::string &message) {
+        erreur = nomManifeste + ":" + std::to_string(numero) + ": " + message;
+        return false;
+    };
+    // argument « @k » : étape lue, sinon la dernière étape déclarée
+    auto operande = [&](std::vector<std::string> &mots, int &etape) {
+        etape = (int) lot.etapes.size();
+        for (size_t i = mots.size(); i-- > 0;)
+            if (mots[i][0] == '@') {
+                etape = std::atoi(mots[i].c_str() + 1);
+                mots.erase(mots.begin() + i);
+                return etape >= 0 && etape <= (int) lot.etapes.size();
+            }
+        return true;
+    };
+
+    for (std::string ligne; std::getline(fichier, ligne);) {
+        numero++;
+        ligne = ligne.substr(0, ligne.find('#'));
+        std::istringstream mots(ligne);
+        std::string directive;
+        if (!(mots >> directive))
+            continue;
+        std::vector<std::string> args;
+        for (std::string mot; mots >> mot;)
+            args.push_back(mot);
+
+        if (directive == "sortie" && args.size() == 1) {
+            lot.sortie = args[0];
+        } else if (directive == "bandes" && args.size() == 1 && std::atoi(args[0].c_str()) >= 0) {
+            lot.parBandes = true;
+            lot.hauteurBande = std::atoi(args[0].c_str());
+        } else if (directive == "entree" && args.size() == 1) {
+            lot.entrees.push_back(args[0]);
+        } else if (directive == "element" && args.size() == 3) {
+            t_ElementStructurant *element = nullptr;
+            if (args[1] == "motif")
+                element = elementMotif(args[2]);
+            else if ((args[1] == "croix" || args[1] == "carre" || args[1] == "losange" || args[1] == "disque") &&
+                     std::atoi(args[2].c_str()) >= 0)
+                element = elementForme(args[1], std::atoi(args[2].c_str()));
+            if (element == nullptr)
+                return echec("élément invalide : " + ligne);
+            lot.elements[args[0]].reset(element);
+        } else if (directive == "etape" && !args.empty()) {
+            t_Etape etape;
+            etape.seuil = 0;
+            etape.seuilAutomatique = false;
+            etape.methode = SEUIL_OTSU;
+            etape.autre = 0;
+            const std::string op = args[0];
+            args.erase(args.begin());
+            if (op == "difference") {
+                if (args.empty() || !operande(args, etape.autre))
+                    return echec("opérande invalide : " + ligne);
+            }
+            if (!operande(args, etape.entree))
+                return echec("opérande invalide : " + ligne);
+
+            if (op == "seuil" && args.size() == 1 && std::atoi(args[0].c_str()) >= 0 &&
+                std::atoi(args[0].c_str()) <= 255) {
+                etape.operateur = OP_SEUIL;
+                etape.seuil = std::atoi(args[0].c_str());
+            } else if (op == "seuil" && args.size() == 1 && (args[0] == "otsu" || args[0] == "triangle")) {
+                etape.operateur = OP_SEUIL;
+                etape.seuilAutomatique = true;
+                etape.methode = args[0] == "otsu" ? SEUIL_OTSU : SEUIL_TRIANGLE;
+            } else if (op == "difference" && args.empty()) {
+                etape.operateur = OP_DIFFERENCE;
+            } else if (args.size() == 1 && (op == "dilatation" || op == "erosion" || op == "ouverture" ||
+                                            op == "fermeture")) {
+                if (lot.elements.count(args[0]) == 0)
+                    return echec("élément inconnu : " + args[0]);
+                etape.operateur = op == "dilatation" ? OP_DILATATION : op == "erosion" ? OP_EROSION :
+                                  op == "ouverture" ? OP_OUVERTURE : OP_FERMETURE;
+                etape.element = args[0];
+            } else {
+                return echec("étape invalide : " + ligne);
+            }
+            lot.etapes.push_back(etape);
+        } else if (directive == "sauver" && !args.empty()) {
+            t_Enregistrement enregistrement;
+            enregistrement.suffixe = args[0];
+            args.erase(args.begin());
+            if (!operande(args, enregistrement.etape))
+                return echec("opérande invalide : " + ligne);
+            enregistrement.format = PGM_ASCII;
+            if (args.size() == 1 && (args[0] == "p2" || args[0] == "p5"))
+                enregistrement.format = args[0] == "p5" ? PGM_BINAIRE : PGM_ASCII;
+            else if (!args.empty())
+                return echec("format invalide : " + ligne);
+            lot.enregistrements.push_back(enregistrement);
+        } else {
+            return echec("directive invalide : " + ligne);
+        }
+    }
+    // l'histogramme d'un seuil automatique demande l'image complète
+    for (const auto &etape: lot.etapes)
+        if (lot.parBandes && etape.seuilAutomatique)
+            return echec("un seuil automatique ne peut pas être calculé par bandes");
+    return true;
+}
+
+// nom du fichier sans dossier ni extension
+static std::string nomSansExtension(const std::string &chemin) {
+    const size_t debut = chemin.find_last_of('/') == std::string::npos ? 0 : chemin.find_last_of('/') + 1;
+    const size_t point = chemin.find_last_of('.');
+    return chemin.substr(debut, point == std::string::npos || point < debut ? std::string::npos : point - debut);
+}
+
+static double millisecondes(const std::chrono::steady_clock::time_point debut,
+                            const std::chrono::steady_clock::time_point fin) {
+    return std::chrono::duration<double, std::milli>(fin - debut).count();
+}
+
+/**
+ * @brief Charge une image du lot, lui applique la chaîne et enregistre les
+ *        étapes demandées. L'image chargée reste en mémoire pour toute la chaîne ;
+ *        les images intermédiaires sont empruntées à la réserve (reserve.h) et
+ *        recyclées d'une image du lot à la suivante. Avec la directive bandes,
+ *        l'image est lue, traitée et enregistrée par bandes.
+ */
+static t_BilanImage traiterImage(const t_Lot &lot, const std::string &entree) {
+    t_BilanImage bilan = {entree, false, 0, 0, 0, 0};
+    const auto debut = std::chrono::steady_clock::now();
+    t_Image image;
+    t_Pipeline pipeline;
+    std::vector<int> noeuds;
+    if (lot.parBandes) {
+        // seul l'entête est lu ici : l'image le sera par bandes
+        fermerPgm(ouvrirPgm(entree, bilan.h, bilan.w, bilan.ok));
+        noeuds.push_back(pipeline.charger(entree));
+    } else {
+        loadPgm(entree, &image, bilan.ok);
+        bilan.w = image.w;
+        bilan.h = image.h;
+        noeuds.push_back(pipeline.source(&image));
+    }
+    const auto charge = std::chrono::steady_clock::now();
+    bilan.chargementMs = millisecondes(debut, charge);
+    if (!bilan.ok)
+        return bilan;
+
+    // étapes calculées en entier avant la chaîne, pour l'histogramme d'un seuil automatique
+    std::vector<std::unique_ptr<t_Image> > calculees;
+    for (const auto &etape: lot.etapes) {
+        int e = noeuds[etape.entree];
+        const t_ElementStructurant *element = etape.element.empty() ? nullptr : lot.elements.at(etape.element).get();
+        switch (etape.operateur) {
+            case OP_SEUIL: {
+                unsigned int s = etape.seuil;
+                if (etape.seuilAutomatique) {
+                    const t_Image *lue = &image;
+                    if (etape.entree != 0) {
+                        calculees.emplace_back(pipeline.calculer(e, bilan.ok));
+                        if (!bilan.ok)
+                            return bilan;
+                        lue = calculees.back().get();
+                        e = pipeline.source(lue);
+                    }
+                    uint64_t histo[256];
+                    histogramme(lue, histo);
+                    s = seuilAutomatique(histo, etape.methode);
+                }
+                noeuds.push_back(pipeline.seuiller(e, s));
+                break;
+            }
+            case OP_DILATATION:
+                noeuds.push_back(pipeline.dilater(e, element));
+                break;
+            case OP_EROSION:
+                noeuds.push_back(pipeline.eroder(e, element));
+                break;
+            case OP_OUVERTURE:
+                noeuds.push_back(pipeline.ouvrir(e, element));
+                break;
+            case OP_FERMETURE:
+                noeuds.push_back(pipeline.fermer(e, element));
+                break;
+            case OP_DIFFERENCE:
+                noeuds.push_back(pipeline.differencier(e, noeuds[etape.autre]));
+                break;
+        }
+    }
+    for (const auto &enregistrement: lot.enregistrements)
+        pipeline.sauver(noeuds[enregistrement.etape],
+                        lot.sortie + "/" + nomSansExtension(entree) + enregistrement.suffixe, enregistrement.format);
+    bilan.ok = lot.parBandes ? pipeline.executerParBandes(lot.hauteurBande) : pipeline.executer();
+    bilan.traitementMs = millisecondes(charge, std::chrono::steady_clock::now());
+    return bilan;
+}
+
+/**
+ * @brief Traite toutes les images du lot.
+ *
+ * Avec au moins autant d'images que de threads, chaque image est traitée par
+ * un seul thread et les images le sont en parallèle ; sinon les images sont
+ * traitées l'une après l'autre, chacune découpée en bandes parallèles.
+ *
+ * @return Mesures de chaque image, dans l'ordre du manifeste.
+ */
+std::vector<t_BilanImage> traiterLot(const t_Lot &lot) {
+    std::vector<t_BilanImage> bilans(lot.entrees.size());
+    if ((int) lot.entrees.size() >= nombreThreads())
+        executerTaches((int) lot.entrees.size(), [&](const int i) { bilans[i] = traiterImage(lot, lot.entrees[i]); });
+    else
+        for (size_t i = 0; i < lot.entrees.size(); i++)
+            bilans[i] = traiterImage(lot, lot.entrees[i]);
+    return bilans;
+}
+
+/**
+ * @brief Lit un manifeste, traite le lot et affiche le débit de chaque image
+ *        et du lot entier.
+ *
+ * @param threads Nombre de threads (0 : voir nombreThreads()).
+ * @return vrai si le manifeste est valide et toutes les images ont été traitées.
+ */
+bool executerLot(const std::string &nomManifeste, const int threads) {
+    t_Lot lot;
+    std::string erreur;
+    if (!lireManifeste(nomManifeste, lot, erreur)) {
+        std::cout << erreur << std::endl;
+        return false;
+    }
+    if (threads > 0)
+        definirNombreThreads(threads);
+
+    const auto debut = std::chrono::steady_clock::now();
+    const std::vector<t_BilanImage> bilans = traiterLot(lot);
+    const double totalMs = millisecondes(debut, std::chrono::steady_clock::now());
+    viderReserve();
+
+    std::cout << "=== Lot : " << bilans.size() << " images, " << lot.etapes.size() << " étapes, "
+              << nombreThreads() << " threads ===" << std::endl;
+    double megapixels = 0;
+    int echecs = 0;
+    char texte[512];
+    for (const auto &b: bilans) {
+        if (!b.ok) {
+            echecs++;
+            std::cout << b.entree << " : échec" << std::endl;
+            continue;
+        }
+        const double mpx = (double) b.w * b.h / 1e6;
+        megapixels += mpx;
+        snprintf(texte, sizeof texte, "%s : %dx%d, chargement %.1f ms, traitement %.1f ms, %.1f Mpx/s",
+                 b.entree.c_str(), b.w, b.h, b.chargementMs, b.traitementMs,
+                 mpx / ((b.chargementMs + b.traitementMs) / 1000));
+        std::cout << texte << std::endl;
+    }
+    snprintf(texte, sizeof texte, "Total : %d images traitées, %d en échec, %.2f Mpx en %.1f ms : %.1f Mpx/s, %.1f images/s",
+             (int) bilans.size() - echecs, echecs, megapixels, totalMs, megapixels / (totalMs / 1000),
+             (bilans.size() - echecs) / (totalMs / 1000));
+    std::cout << texte << std::endl;
+    return echecs == 0;
+}
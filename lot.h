@@ -0,0 +1,82 @@
+//
+// Traitement par lot : une même chaîne d'opérateurs appliquée à une liste
+// d'images décrite dans un manifeste, les images étant traitées en parallèle.
+//
+// Format du manifeste (une directive par ligne, # commence un commentaire) :
+//
+//     sortie   images_generees/         dossier des images produites (défaut : .)
+//     bandes   256                      lecture, calcul et écriture par bandes de 256
+//                                       lignes (0 : hauteur automatique), pour les
+//                                       images trop grandes pour la mémoire
+//     element  c3 croix 1               croix, carre, losange ou disque de rayon donné
+//     element  m3 motif 010/111/010     cellules actives à 1, centre au milieu
+//     etape    seuil 100                étape 1 (lit l'image d'entrée) ; seuil otsu ou
+//                                       seuil triangle calcule le seuil de chaque image
+//     etape    ouverture c3             étape 2 (lit l'étape 1)
+//     etape    difference @1            étape 3 : différence entre l'étape 2 et l'étape 1
+//     sauver   _diff.pgm p5             enregistre l'étape 3 sous <sortie>/<nom>_diff.pgm
+//     entree   tp3-images/plane512x512.pgm
+//
+// Opérateurs : seuil S|otsu|triangle, dilatation E, erosion E, ouverture E, fermeture E,
+// difference @k. Chaque opérateur lit l'étape précédente, ou l'étape @k
+// donnée en argument (@0 désigne l'image d'entrée). sauver enregistre la
+// dernière étape déclarée, ou l'étape @k, en P2 (défaut) ou en P5.
+//
+
+#ifndef SMP_TP3_LOT_H
+#define SMP_TP3_LOT_H
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "chargesauve.h"
+#include "outils.h"
+
+typedef enum {
+    OP_SEUIL,
+    OP_DILATATION,
+    OP_EROSION,
+    OP_OUVERTURE,
+    OP_FERMETURE,
+    OP_DIFFERENCE
+} t_Operateur;
+
+typedef struct {
+    t_Operateur operateur;
+    int entree;             // étape lue (0 : image d'entrée)
+    int autre;              // second opérande de OP_DIFFERENCE
+    unsigned int seuil;     // OP_SEUIL
+    bool seuilAutomatique;  // OP_SEUIL : seuil calculé par methode sur l'image lue
+    t_MethodeSeuil methode;
+    std::string element;    // nom de l'élément des opérateurs morphologiques
+} t_Etape;
+
+typedef struct {
+    int etape;
+    std::string suffixe;
+    t_FormatPgm format;
+} t_Enregistrement;
+
+struct t_Lot {
+    std::string sortie = ".";
+    bool parBandes = false;     // voir t_Pipeline::executerParBandes
+    int hauteurBande = 0;
+    std::map<std::string, std::shared_ptr<t_ElementStructurant> > elements;
+    std::vector<t_Etape> etapes;
+    std::vector<t_Enregistrement> enregistrements;
+    std::vector<std::string> entrees;
+};
+
+// mesures d'une image du lot
+typedef struct {
+    std::string entree;
+    bool ok;
+    int w, h;
+    double chargementMs, traitementMs;
+} t_BilanImage;
+
+t_ElementStructurant *elementForme(const std::string &forme, int rayon);
+bool lireManifeste(const std::string &nomManifeste, t_Lot &lot, std::string &erreur);
+std::vector<t_BilanImage> traiterLot(const t_Lot &lot);
+bool executerLot(const std::string &nomManifeste, int threads = 0);
+#endif //SMP_TP3_LOT_H
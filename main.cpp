@@ -2,39 +2,36 @@
 #include "chargesauve.h"
 #include  "image.h"
 #include "outils.h"
+#include "lot.h"
+#include "reserve.h"
 #include <cassert>
+#include <cstdlib>
 
 using namespace std;
 
-int main() {
+//dossier des images de la démonstration, relatif au répertoire courant, si aucun n'est donné
+const string DOSSIER_IMAGES = "tp3-images/";
+
+static int demonstration(const string &dossier) {
     cout << "=== Binarisation de l'image  ===" << endl;
     auto image_kodie = createImage();
     bool ok = false;
 
     int seuil = 50;
 
-    loadPgm("/Users/davidprosperin/CLionProjects/smp_tp3/tp3-images/kodie512x512.pgm", image_kodie, ok);
+    //le seuillage est appliqué pendant le chargement : l'image en niveaux de gris n'est jamais construite
+    loadPgmSeuil(dossier + "kodie512x512.pgm", seuil, image_kodie, ok);
     cout << ok << endl;
 
-    if (ok) {
-        seuillage(image_kodie, seuil);
-    }
-
-    string sortieFichier = "/Users/davidprosperin/CLionProjects/smp_tp3/tp3-images/kodie512x512seuil"
+    string sortieFichier = dossier + "kodie512x512seuil"
                      + to_string(seuil)
                      + ".pgm";
 
     savePgm(sortieFichier, image_kodie);
-    delete image_kodie;
-
-    cout << "=== Chargement de l'image kodie512x512seuil50 ===" << endl;
 
-    auto image_kodie_seuil50 = createImage();
-    bool ok2 = false;
-
-    loadPgm("/Users/davidprosperin/CLionProjects/smp_tp3/tp3-images/kodie512x512seuil50.pgm", image_kodie_seuil50, ok2);
-
-    assert(ok2 && "Problème lors du chargement de l'image kodie512x512seuil50.pgm");
+    //l'image seuillée est déjà en mémoire : inutile de relire le fichier qui vient d'être écrit
+    assert(ok && "Problème lors du chargement de l'image kodie512x512.pgm");
+    auto image_kodie_seuil50 = image_kodie;
 
     cout << "=== Dilatation ===" << endl;
 
@@ -55,7 +52,7 @@ int main() {
 
     dilatation(image_kodie_seuil50, image_contour, element3x3, BLACK);
 
-    string sortieFichierContour = "/Users/davidprosperin/CLionProjects/smp_tp3/tp3-images/kodie512x512seuil50dilatation3x3.pgm";
+    string sortieFichierContour = dossier + "kodie512x512seuil50dilatation3x3.pgm";
     savePgm(sortieFichierContour, image_contour);
 
     cout << "==== Dilatation avec un élément structurant de taille 5x5 ==== " << endl;
@@ -84,7 +81,7 @@ int main() {
 
     dilatation(image_kodie_seuil50, image_kodie_dilatation5x5, element5x5, BLACK);
 
-    savePgm("/Users/davidprosperin/CLionProjects/smp_tp3/tp3-images/kodie512x512seuil50dilatation5x5.pgm", image_kodie_dilatation5x5);
+    savePgm(dossier + "kodie512x512seuil50dilatation5x5.pgm", image_kodie_dilatation5x5);
 
     cout << "=== Erosion élément structurant 3x3 ===" << endl;
 
@@ -92,7 +89,7 @@ int main() {
 
     erosion(image_kodie_seuil50, image_kodie_erosion3x3, element3x3, BLACK);
 
-    savePgm("/Users/davidprosperin/CLionProjects/smp_tp3/tp3-images/kodie512x512seuil50erosion3x3.pgm", image_kodie_erosion3x3);
+    savePgm(dossier + "kodie512x512seuil50erosion3x3.pgm", image_kodie_erosion3x3);
 
     cout << "=== Ouverture élément structurant 3x3 ===" << endl;
 
@@ -100,7 +97,7 @@ int main() {
 
     ouverture(image_kodie_seuil50, image_kodie_ouverture3x3, element3x3, BLACK);
 
-    savePgm("/Users/davidprosperin/CLionProjects/smp_tp3/tp3-images/kodie512x512seuil50ouverture3x3.pgm",
+    savePgm(dossier + "kodie512x512seuil50ouverture3x3.pgm",
             image_kodie_ouverture3x3);
 
     cout << "=== Fermeture élément structurant 3x3 ===" << endl;
@@ -109,7 +106,7 @@ int main() {
 
     fermeture(image_kodie_seuil50, image_kodie_fermeture3x3, element3x3, BLACK);
 
-    savePgm("/Users/davidprosperin/CLionProjects/smp_tp3/tp3-images/kodie512x512seuil50fermeture3x3.pgm",
+    savePgm(dossier + "kodie512x512seuil50fermeture3x3.pgm",
             image_kodie_fermeture3x3);
 
     cout << "=== Différence : monarch512x512 - lena512x512 ===" << endl;
@@ -117,14 +114,14 @@ int main() {
     auto image_monarch = createImage();
     bool monarch_loaded = false;
 
-    loadPgm("/Users/davidprosperin/CLionProjects/smp_tp3/tp3-images/monarch512x512.pgm", image_monarch, monarch_loaded);
+    loadPgm(dossier + "monarch512x512.pgm", image_monarch, monarch_loaded);
 
     assert(monarch_loaded && "Erreur lors du chargement de l'image monarch512x512.pgm");
 
     auto image_lena = createImage();
     bool lena_loaded = false;
 
-    loadPgm("/Users/davidprosperin/CLionProjects/smp_tp3/tp3-images/lena512x512.pgm", image_lena, lena_loaded);
+    loadPgm(dossier + "lena512x512.pgm", image_lena, lena_loaded);
 
     assert(lena_loaded && "Erreur lors du chargement de l'image lena512x512.pgm");
 
@@ -132,35 +129,33 @@ int main() {
 
     difference(image_monarch, image_lena, diff_monarch_lena);
 
-    savePgm("/Users/davidprosperin/CLionProjects/smp_tp3/tp3-images/diff_monarch_lena.pgm", diff_monarch_lena);
+    savePgm(dossier + "diff_monarch_lena.pgm", diff_monarch_lena);
 
     cout << "=== Difference : plane512x512 seuillé à 100 - plane512x512 apres ouverture 3x3 ===" << endl;
 
     auto image_plane = createImage();
     bool plane_loaded = false;
 
-    loadPgm("/Users/davidprosperin/CLionProjects/smp_tp3/tp3-images/plane512x512.pgm", image_plane, plane_loaded);
-
-    assert(plane_loaded && "Erreur lors du chargement de l'image plane512x512.pgm");
-
     seuil = 100;
 
-    seuillage(image_plane, seuil);
+    loadPgmSeuil(dossier + "plane512x512.pgm", seuil, image_plane, plane_loaded);
+
+    assert(plane_loaded && "Erreur lors du chargement de l'image plane512x512.pgm");
 
-    savePgm("/Users/davidprosperin/CLionProjects/smp_tp3/tp3-images/plane512x512seuil100.pgm", image_plane);
+    savePgm(dossier + "plane512x512seuil100.pgm", image_plane);
 
     auto image_plane_ouverture3x3 = createImage(image_plane->h, image_plane->w);
 
     ouverture(image_plane, image_plane_ouverture3x3, element3x3, BLACK);
 
-    savePgm("/Users/davidprosperin/CLionProjects/smp_tp3/tp3-images/plane512x512seuil100ouverture3x3.pgm",
+    savePgm(dossier + "plane512x512seuil100ouverture3x3.pgm",
             image_plane_ouverture3x3);
 
     auto diff_seuil100_ouverture3x3 = createImage(image_plane->h, image_plane->w);
 
     difference(image_plane, image_plane_ouverture3x3, diff_seuil100_ouverture3x3);
 
-    savePgm("/Users/davidprosperin/CLionProjects/smp_tp3/tp3-images/plane512x512_diff_seuil100_seuil100ouverture3x3.pgm",
+    savePgm(dossier + "plane512x512_diff_seuil100_seuil100ouverture3x3.pgm",
             diff_seuil100_ouverture3x3);
 
     cout << "=== Difference : plane512x512 seuillé à 100 - plane512x512 apres fermeture 3x3 ===" << endl;
@@ -169,14 +164,14 @@ int main() {
 
     fermeture(image_plane, image_plane_fermeture3x3, element3x3, BLACK);
 
-    savePgm("/Users/davidprosperin/CLionProjects/smp_tp3/tp3-images/plane512x512seuil100fermeture3x3.pgm",
+    savePgm(dossier + "plane512x512seuil100fermeture3x3.pgm",
             image_plane_fermeture3x3);
 
     auto diff_seuil100_fermeture3x3 = createImage(image_plane->h, image_plane->w);
 
     difference(image_plane, image_plane_fermeture3x3, diff_seuil100_fermeture3x3);
 
-    savePgm("/Users/davidprosperin/CLionProjects/smp_tp3/tp3-images/plane512x512_diff_seuil100_seuil100fermeture3x3.pgm",
+    savePgm(dossier + "plane512x512_diff_seuil100_seuil100fermeture3x3.pgm",
             diff_seuil100_fermeture3x3);
 
 
@@ -192,6 +187,26 @@ int main() {
     delete diff_seuil100_ouverture3x3;
     delete image_plane_fermeture3x3;
     delete diff_seuil100_fermeture3x3;
+    viderReserve();
 
     return 0;
 }
+
+/*
+Utilisation :
+  main                     démonstration sur les images de DOSSIER_IMAGES
+  main demo <dossier>      démonstration sur les images de <dossier>
+  main lot <manifeste> [threads]
+                           traitement par lot décrit dans <manifeste> (voir lot.h)
+*/
+int main(int argc, char *argv[]) {
+    const string mode = argc >= 2 ? argv[1] : "demo";
+
+    if (mode == "lot" && (argc == 3 || argc == 4))
+        return executerLot(argv[2], argc == 4 ? atoi(argv[3]) : 0) ? 0 : 1;
+    if (mode == "demo" && argc <= 3)
+        return demonstration(argc == 3 ? argv[2] : DOSSIER_IMAGES);
+
+    cout << "utilisation : " << argv[0] << " [demo [dossier] | lot manifeste [threads]]" << endl;
+    return 1;
+}
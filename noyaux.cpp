@@ -0,0 +1,727 @@
+//
+// Noyaux vectoriels (SSE2, AVX2, AVX-512) de la morphologie, choisis au démarrage
+// selon le processeur.
+//
+
+#include "noyaux.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SMP_X86 1
+#include <immintrin.h>
+#endif
+
+/*
+ * Les érosions et dilatations de outils.cpp se ramènent à des minimums et des
+ * maximums sur des lignes décalées :
+ * - un pixel est dilaté si l'un des pixels recouverts par l'élément est BLACK,
+ *   c'est-à-dire si leur minimum vaut 0 ;
+ * - un pixel est érodé si tous les pixels recouverts sont BLACK, c'est-à-dire
+ *   si leur maximum vaut 0.
+ * Les cellules hors de l'image sont ignorées : elles valent l'élément neutre
+ * (255 pour le minimum, 0 pour le maximum) et ne sont donc jamais lues.
+ */
+
+// ---------------------------------------------------------------------------
+// Version portable : le compilateur vectorise ces boucles lorsqu'il le peut.
+// ---------------------------------------------------------------------------
+
+static void minLigneGenerique(t_Pixel *acc, const t_Pixel *src, const int n) {
+    for (int x = 0; x < n; x++)
+        acc[x] = std::min(acc[x], src[x]);
+}
+
+static void maxLigneGenerique(t_Pixel *acc, const t_Pixel *src, const int n) {
+    for (int x = 0; x < n; x++)
+        acc[x] = std::max(acc[x], src[x]);
+}
+
+static void minMaxLigneGenerique(t_Pixel *accMin, t_Pixel *accMax, const t_Pixel *src, const int n) {
+    for (int x = 0; x < n; x++) {
+        accMin[x] = std::min(accMin[x], src[x]);
+        accMax[x] = std::max(accMax[x], src[x]);
+    }
+}
+
+static void remplirSiNulGenerique(t_Pixel *dst, const t_Pixel *acc, const int n, const t_Pixel couleur) {
+    for (int x = 0; x < n; x++)
+        dst[x] = acc[x] == 0 ? couleur : dst[x];
+}
+
+static void seuillerLigneGenerique(t_Pixel *dst, const t_Pixel *src, const int n, const t_Pixel s) {
+    for (int x = 0; x < n; x++)
+        dst[x] = src[x] < s ? 0 : 255;
+}
+
+// mots de 64 pixels à partir du pixel x ; le dernier mot, incomplet, a ses bits
+// au-delà de n nuls
+static void compacterSeuilFin(uint64_t *dst, const t_Pixel *src, int x, const int n, const t_Pixel s) {
+    for (; x < n; x += 64) {
+        const int fin = x + 64 < n ? x + 64 : n;
+        uint64_t mot = 0;
+        for (int k = x; k < fin; k++)
+            mot |= uint64_t(src[k] < s) << (k - x);
+        dst[x / 64] = mot;
+    }
+}
+
+static void compacterSeuilGenerique(uint64_t *dst, const t_Pixel *src, const int n, const t_Pixel s) {
+    compacterSeuilFin(dst, src, 0, n, s);
+}
+
+// pixels x à n - 1 de la différence ; bilan complète le bilan des pixels précédents
+static void differenceFin(t_Pixel *dst, const t_Pixel *a, const t_Pixel *b, int x, const int n,
+                          const t_Pixel tolerance, t_DifferenceLigne &bilan) {
+    for (; x < n; x++) {
+        const t_Pixel d = a[x] > b[x] ? a[x] - b[x] : b[x] - a[x];
+        dst[x] = d;
+        bilan.somme += d;
+        if (d > tolerance) {
+            bilan.changes++;
+            bilan.premier = std::min(bilan.premier, x);
+            bilan.dernier = x;
+        }
+    }
+}
+
+static t_DifferenceLigne differenceLigneGenerique(t_Pixel *dst, const t_Pixel *a, const t_Pixel *b, const int n,
+                                                  const t_Pixel tolerance) {
+    t_DifferenceLigne bilan = {0, 0, n, -1};
+    differenceFin(dst, a, b, 0, n, tolerance, bilan);
+    return bilan;
+}
+
+// mots de 64 pixels à partir du pixel x, ajoutés à dst
+static void marquerInferieursFin(uint64_t *dst, const t_Pixel *a, const t_Pixel *b, const t_Pixel *c, int x,
+                                 const int n) {
+    for (; x < n; x += 64) {
+        const int fin = x + 64 < n ? x + 64 : n;
+        uint64_t mot = 0;
+        for (int k = x; k < fin; k++)
+            mot |= uint64_t(a[k] < std::min(b[k], c[k])) << (k - x);
+        dst[x / 64] |= mot;
+    }
+}
+
+static void marquerInferieursGenerique(uint64_t *dst, const t_Pixel *a, const t_Pixel *b, const t_Pixel *c,
+                                       const int n) {
+    marquerInferieursFin(dst, a, b, c, 0, n);
+}
+
+// ajoute au bilan les pixels changés d'un bloc commençant en x, donnés par masque
+static inline void compterChanges(t_DifferenceLigne &bilan, const uint64_t masque, const int x) {
+    if (masque == 0)
+        return;
+    bilan.changes += __builtin_popcountll(masque);
+    bilan.premier = std::min(bilan.premier, x + __builtin_ctzll(masque));
+    bilan.dernier = x + 63 - __builtin_clzll(masque);
+}
+
+#ifdef SMP_X86
+
+// ---------------------------------------------------------------------------
+// SSE2 : 16 pixels par instruction.
+// ---------------------------------------------------------------------------
+
+__attribute__((target("sse2")))
+static void minLigneSse2(t_Pixel *acc, const t_Pixel *src, const int n) {
+    int x = 0;
+    for (; x + 16 <= n; x += 16) {
+        const __m128i a = _mm_loadu_si128((const __m128i *) (acc + x));
+        const __m128i s = _mm_loadu_si128((const __m128i *) (src + x));
+        _mm_storeu_si128((__m128i *) (acc + x), _mm_min_epu8(a, s));
+    }
+    for (; x < n; x++)
+        acc[x] = std::min(acc[x], src[x]);
+}
+
+__attribute__((target("sse2")))
+static void maxLigneSse2(t_Pixel *acc, const t_Pixel *src, const int n) {
+    int x = 0;
+    for (; x + 16 <= n; x += 16) {
+        const __m128i a = _mm_loadu_si128((const __m128i *) (acc + x));
+        const __m128i s = _mm_loadu_si128((const __m128i *) (src + x));
+        _mm_storeu_si128((__m128i *) (acc + x), _mm_max_epu8(a, s));
+    }
+    for (; x < n; x++)
+        acc[x] = std::max(acc[x], src[x]);
+}
+
+__attribute__((target("sse2")))
+static void minMaxLigneSse2(t_Pixel *accMin, t_Pixel *accMax, const t_Pixel *src, const int n) {
+    int x = 0;
+    for (; x + 16 <= n; x += 16) {
+        const __m128i s = _mm_loadu_si128((const __m128i *) (src + x));
+        const __m128i a = _mm_loadu_si128((const __m128i *) (accMin + x));
+        const __m128i b = _mm_loadu_si128((const __m128i *) (accMax + x));
+        _mm_storeu_si128((__m128i *) (accMin + x), _mm_min_epu8(a, s));
+        _mm_storeu_si128((__m128i *) (accMax + x), _mm_max_epu8(b, s));
+    }
+    minMaxLigneGenerique(accMin + x, accMax + x, src + x, n - x);
+}
+
+__attribute__((target("sse2")))
+static void remplirSiNulSse2(t_Pixel *dst, const t_Pixel *acc, const int n, const t_Pixel couleur) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c = _mm_set1_epi8((char) couleur);
+    int x = 0;
+    for (; x + 16 <= n; x += 16) {
+        const __m128i a = _mm_loadu_si128((const __m128i *) (acc + x));
+        const __m128i d = _mm_loadu_si128((const __m128i *) (dst + x));
+        const __m128i nul = _mm_cmpeq_epi8(a, zero);
+        _mm_storeu_si128((__m128i *) (dst + x), _mm_or_si128(_mm_and_si128(nul, c), _mm_andnot_si128(nul, d)));
+    }
+    for (; x < n; x++)
+        dst[x] = acc[x] == 0 ? couleur : dst[x];
+}
+
+/*
+ * Seuillage : la table 256 entrées « 0 si p < s, 255 sinon » est une marche,
+ * calculée sans lecture de table : p >= s si et seulement si max(p, s) == p, et
+ * la comparaison donne directement 0x00 ou 0xFF.
+ */
+__attribute__((target("sse2")))
+static void seuillerLigneSse2(t_Pixel *dst, const t_Pixel *src, const int n, const t_Pixel s) {
+    const __m128i seuil = _mm_set1_epi8((char) s);
+    int x = 0;
+    for (; x + 16 <= n; x += 16) {
+        const __m128i p = _mm_loadu_si128((const __m128i *) (src + x));
+        _mm_storeu_si128((__m128i *) (dst + x), _mm_cmpeq_epi8(_mm_max_epu8(p, seuil), p));
+    }
+    for (; x < n; x++)
+        dst[x] = src[x] < s ? 0 : 255;
+}
+
+// compactage : les masques de signe de quatre comparaisons forment un mot
+__attribute__((target("sse2")))
+static void compacterSeuilSse2(uint64_t *dst, const t_Pixel *src, const int n, const t_Pixel s) {
+    const __m128i seuil = _mm_set1_epi8((char) s);
+    int x = 0;
+    for (; x + 64 <= n; x += 64) {
+        uint64_t superieurs = 0;
+        for (int k = 0; k < 4; k++) {
+            const __m128i p = _mm_loadu_si128((const __m128i *) (src + x + 16 * k));
+            superieurs |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(p, seuil), p))
+                    << (16 * k);
+        }
+        dst[x / 64] = ~superieurs;
+    }
+    compacterSeuilFin(dst, src, x, n, s);
+}
+
+// a < min(b, c) si et seulement si max(a, min(b, c)) != a
+__attribute__((target("sse2")))
+static void marquerInferieursSse2(uint64_t *dst, const t_Pixel *a, const t_Pixel *b, const t_Pixel *c, const int n) {
+    int x = 0;
+    for (; x + 64 <= n; x += 64) {
+        uint64_t superieurs = 0;
+        for (int k = 0; k < 4; k++) {
+            const int i = x + 16 * k;
+            const __m128i pa = _mm_loadu_si128((const __m128i *) (a + i));
+            const __m128i m = _mm_min_epu8(_mm_loadu_si128((const __m128i *) (b + i)),
+                                           _mm_loadu_si128((const __m128i *) (c + i)));
+            superieurs |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(pa, m), pa))
+                    << (16 * k);
+        }
+        dst[x / 64] |= ~superieurs;
+    }
+    marquerInferieursFin(dst, a, b, c, x, n);
+}
+
+/*
+ * Différence : |a - b| = sat(a - b) | sat(b - a) ; psadbw somme les écarts par
+ * groupes de 8 octets, et les pixels changés sont ceux dont l'écart diminué de
+ * la tolérance (avec saturation) n'est pas nul.
+ */
+__attribute__((target("sse2")))
+static t_DifferenceLigne differenceLigneSse2(t_Pixel *dst, const t_Pixel *a, const t_Pixel *b, const int n,
+                                             const t_Pixel tolerance) {
+    const __m128i zero = _mm_setzero_si128(), tol = _mm_set1_epi8((char) tolerance);
+    __m128i somme = zero;
+    t_DifferenceLigne bilan = {0, 0, n, -1};
+    int x = 0;
+    for (; x + 16 <= n; x += 16) {
+        const __m128i pa = _mm_loadu_si128((const __m128i *) (a + x));
+        const __m128i pb = _mm_loadu_si128((const __m128i *) (b + x));
+        const __m128i d = _mm_or_si128(_mm_subs_epu8(pa, pb), _mm_subs_epu8(pb, pa));
+        _mm_storeu_si128((__m128i *) (dst + x), d);
+        somme = _mm_add_epi64(somme, _mm_sad_epu8(d, zero));
+        const int egaux = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_subs_epu8(d, tol), zero));
+        compterChanges(bilan, (uint64_t) (~egaux & 0xFFFF), x);
+    }
+    bilan.somme = (uint64_t) _mm_cvtsi128_si64(somme) + (uint64_t) _mm_cvtsi128_si64(_mm_unpackhi_epi64(somme, somme));
+    differenceFin(dst, a, b, x, n, tolerance, bilan);
+    return bilan;
+}
+
+// ---------------------------------------------------------------------------
+// AVX2 : 32 pixels par instruction.
+// ---------------------------------------------------------------------------
+
+__attribute__((target("avx2")))
+static void minLigneAvx2(t_Pixel *acc, const t_Pixel *src, const int n) {
+    int x = 0;
+    for (; x + 32 <= n; x += 32) {
+        const __m256i a = _mm256_loadu_si256((const __m256i *) (acc + x));
+        const __m256i s = _mm256_loadu_si256((const __m256i *) (src + x));
+        _mm256_storeu_si256((__m256i *) (acc + x), _mm256_min_epu8(a, s));
+    }
+    for (; x < n; x++)
+        acc[x] = std::min(acc[x], src[x]);
+}
+
+__attribute__((target("avx2")))
+static void maxLigneAvx2(t_Pixel *acc, const t_Pixel *src, const int n) {
+    int x = 0;
+    for (; x + 32 <= n; x += 32) {
+        const __m256i a = _mm256_loadu_si256((const __m256i *) (acc + x));
+        const __m256i s = _mm256_loadu_si256((const __m256i *) (src + x));
+        _mm256_storeu_si256((__m256i *) (acc + x), _mm256_max_epu8(a, s));
+    }
+    for (; x < n; x++)
+        acc[x] = std::max(acc[x], src[x]);
+}
+
+__attribute__((target("avx2")))
+static void minMaxLigneAvx2(t_Pixel *accMin, t_Pixel *accMax, const t_Pixel *src, const int n) {
+    int x = 0;
+    for (; x + 32 <= n; x += 32) {
+        const __m256i s = _mm256_loadu_si256((const __m256i *) (src + x));
+        const __m256i a = _mm256_loadu_si256((const __m256i *) (accMin + x));
+        const __m256i b = _mm256_loadu_si256((const __m256i *) (accMax + x));
+        _mm256_storeu_si256((__m256i *) (accMin + x), _mm256_min_epu8(a, s));
+        _mm256_storeu_si256((__m256i *) (accMax + x), _mm256_max_epu8(b, s));
+    }
+    minMaxLigneGenerique(accMin + x, accMax + x, src + x, n - x);
+}
+
+__attribute__((target("avx2")))
+static void remplirSiNulAvx2(t_Pixel *dst, const t_Pixel *acc, const int n, const t_Pixel couleur) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i c = _mm256_set1_epi8((char) couleur);
+    int x = 0;
+    for (; x + 32 <= n; x += 32) {
+        const __m256i a = _mm256_loadu_si256((const __m256i *) (acc + x));
+        const __m256i d = _mm256_loadu_si256((const __m256i *) (dst + x));
+        const __m256i nul = _mm256_cmpeq_epi8(a, zero);
+        _mm256_storeu_si256((__m256i *) (dst + x), _mm256_blendv_epi8(d, c, nul));
+    }
+    for (; x < n; x++)
+        dst[x] = acc[x] == 0 ? couleur : dst[x];
+}
+
+__attribute__((target("avx2")))
+static void seuillerLigneAvx2(t_Pixel *dst, const t_Pixel *src, const int n, const t_Pixel s) {
+    const __m256i seuil = _mm256_set1_epi8((char) s);
+    int x = 0;
+    for (; x + 32 <= n; x += 32) {
+        const __m256i p = _mm256_loadu_si256((const __m256i *) (src + x));
+        _mm256_storeu_si256((__m256i *) (dst + x), _mm256_cmpeq_epi8(_mm256_max_epu8(p, seuil), p));
+    }
+    for (; x < n; x++)
+        dst[x] = src[x] < s ? 0 : 255;
+}
+
+__attribute__((target("avx2")))
+static void compacterSeuilAvx2(uint64_t *dst, const t_Pixel *src, const int n, const t_Pixel s) {
+    const __m256i seuil = _mm256_set1_epi8((char) s);
+    int x = 0;
+    for (; x + 64 <= n; x += 64) {
+        const __m256i p0 = _mm256_loadu_si256((const __m256i *) (src + x));
+        const __m256i p1 = _mm256_loadu_si256((const __m256i *) (src + x + 32));
+        const uint64_t bas = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(p0, seuil), p0));
+        const uint64_t haut = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(p1, seuil), p1));
+        dst[x / 64] = ~(bas | haut << 32);
+    }
+    compacterSeuilFin(dst, src, x, n, s);
+}
+
+__attribute__((target("avx2")))
+static void marquerInferieursAvx2(uint64_t *dst, const t_Pixel *a, const t_Pixel *b, const t_Pixel *c, const int n) {
+    int x = 0;
+    for (; x + 64 <= n; x += 64) {
+        uint64_t superieurs = 0;
+        for (int k = 0; k < 2; k++) {
+            const int i = x + 32 * k;
+            const __m256i pa = _mm256_loadu_si256((const __m256i *) (a + i));
+            const __m256i m = _mm256_min_epu8(_mm256_loadu_si256((const __m256i *) (b + i)),
+                                              _mm256_loadu_si256((const __m256i *) (c + i)));
+            superieurs |= (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(pa, m), pa))
+                    << (32 * k);
+        }
+        dst[x / 64] |= ~superieurs;
+    }
+    marquerInferieursFin(dst, a, b, c, x, n);
+}
+
+__attribute__((target("avx2")))
+static t_DifferenceLigne differenceLigneAvx2(t_Pixel *dst, const t_Pixel *a, const t_Pixel *b, const int n,
+                                             const t_Pixel tolerance) {
+    const __m256i zero = _mm256_setzero_si256(), tol = _mm256_set1_epi8((char) tolerance);
+    __m256i somme = zero;
+    t_DifferenceLigne bilan = {0, 0, n, -1};
+    int x = 0;
+    for (; x + 32 <= n; x += 32) {
+        const __m256i pa = _mm256_loadu_si256((const __m256i *) (a + x));
+        const __m256i pb = _mm256_loadu_si256((const __m256i *) (b + x));
+        const __m256i d = _mm256_or_si256(_mm256_subs_epu8(pa, pb), _mm256_subs_epu8(pb, pa));
+        _mm256_storeu_si256((__m256i *) (dst + x), d);
+        somme = _mm256_add_epi64(somme, _mm256_sad_epu8(d, zero));
+        const uint32_t egaux = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_subs_epu8(d, tol), zero));
+        compterChanges(bilan, (uint64_t) ~egaux & 0xFFFFFFFFu, x);
+    }
+    uint64_t parties[4];
+    _mm256_storeu_si256((__m256i *) parties, somme);
+    bilan.somme = parties[0] + parties[1] + parties[2] + parties[3];
+    differenceFin(dst, a, b, x, n, tolerance, bilan);
+    return bilan;
+}
+
+// ---------------------------------------------------------------------------
+// AVX-512 (BW) : 64 pixels par instruction.
+// ---------------------------------------------------------------------------
+
+__attribute__((target("avx512f,avx512bw")))
+static void minLigneAvx512(t_Pixel *acc, const t_Pixel *src, const int n) {
+    int x = 0;
+    for (; x + 64 <= n; x += 64) {
+        const __m512i a = _mm512_loadu_si512(acc + x);
+        const __m512i s = _mm512_loadu_si512(src + x);
+        _mm512_storeu_si512(acc + x, _mm512_min_epu8(a, s));
+    }
+    for (; x < n; x++)
+        acc[x] = std::min(acc[x], src[x]);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void maxLigneAvx512(t_Pixel *acc, const t_Pixel *src, const int n) {
+    int x = 0;
+    for (; x + 64 <= n; x += 64) {
+        const __m512i a = _mm512_loadu_si512(acc + x);
+        const __m512i s = _mm512_loadu_si512(src + x);
+        _mm512_storeu_si512(acc + x, _mm512_max_epu8(a, s));
+    }
+    for (; x < n; x++)
+        acc[x] = std::max(acc[x], src[x]);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void minMaxLigneAvx512(t_Pixel *accMin, t_Pixel *accMax, const t_Pixel *src, const int n) {
+    int x = 0;
+    for (; x + 64 <= n; x += 64) {
+        const __m512i s = _mm512_loadu_si512(src + x);
+        const __m512i a = _mm512_loadu_si512(accMin + x);
+        const __m512i b = _mm512_loadu_si512(accMax + x);
+        _mm512_storeu_si512(accMin + x, _mm512_min_epu8(a, s));
+        _mm512_storeu_si512(accMax + x, _mm512_max_epu8(b, s));
+    }
+    minMaxLigneGenerique(accMin + x, accMax + x, src + x, n - x);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void remplirSiNulAvx512(t_Pixel *dst, const t_Pixel *acc, const int n, const t_Pixel couleur) {
+    const __m512i c = _mm512_set1_epi8((char) couleur);
+    int x = 0;
+    for (; x + 64 <= n; x += 64) {
+        const __m512i a = _mm512_loadu_si512(acc + x);
+        const __mmask64 nul = _mm512_testn_epi8_mask(a, a);
+        _mm512_mask_storeu_epi8(dst + x, nul, c);
+    }
+    for (; x < n; x++)
+        dst[x] = acc[x] == 0 ? couleur : dst[x];
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void seuillerLigneAvx512(t_Pixel *dst, const t_Pixel *src, const int n, const t_Pixel s) {
+    const __m512i seuil = _mm512_set1_epi8((char) s);
+    int x = 0;
+    for (; x + 64 <= n; x += 64) {
+        const __m512i p = _mm512_loadu_si512(src + x);
+        _mm512_storeu_si512(dst + x, _mm512_movm_epi8(_mm512_cmpge_epu8_mask(p, seuil)));
+    }
+    for (; x < n; x++)
+        dst[x] = src[x] < s ? 0 : 255;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void compacterSeuilAvx512(uint64_t *dst, const t_Pixel *src, const int n, const t_Pixel s) {
+    const __m512i seuil = _mm512_set1_epi8((char) s);
+    int x = 0;
+    for (; x + 64 <= n; x += 64)
+        dst[x / 64] = _mm512_cmplt_epu8_mask(_mm512_loadu_si512(src + x), seuil);
+    compacterSeuilFin(dst, src, x, n, s);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void marquerInferieursAvx512(uint64_t *dst, const t_Pixel *a, const t_Pixel *b, const t_Pixel *c,
+                                    const int n) {
+    int x = 0;
+    for (; x + 64 <= n; x += 64) {
+        const __m512i m = _mm512_min_epu8(_mm512_loadu_si512(b + x), _mm512_loadu_si512(c + x));
+        dst[x / 64] |= _mm512_cmplt_epu8_mask(_mm512_loadu_si512(a + x), m);
+    }
+    marquerInferieursFin(dst, a, b, c, x, n);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static t_DifferenceLigne differenceLigneAvx512(t_Pixel *dst, const t_Pixel *a, const t_Pixel *b, const int n,
+                                               const t_Pixel tolerance) {
+    const __m512i zero = _mm512_setzero_si512(), tol = _mm512_set1_epi8((char) tolerance);
+    __m512i somme = zero;
+    t_DifferenceLigne bilan = {0, 0, n, -1};
+    int x = 0;
+    for (; x + 64 <= n; x += 64) {
+        const __m512i pa = _mm512_loadu_si512(a + x);
+        const __m512i pb = _mm512_loadu_si512(b + x);
+        const __m512i d = _mm512_sub_epi8(_mm512_max_epu8(pa, pb), _mm512_min_epu8(pa, pb));
+        _mm512_storeu_si512(dst + x, d);
+        somme = _mm512_add_epi64(somme, _mm512_sad_epu8(d, zero));
+        compterChanges(bilan, _mm512_cmpgt_epu8_mask(d, tol), x);
+    }
+    uint64_t parties[8];
+    _mm512_storeu_si512(parties, somme);
+    bilan.somme = 0;
+    for (const uint64_t partie: parties)
+        bilan.somme += partie;
+    differenceFin(dst, a, b, x, n, tolerance, bilan);
+    return bilan;
+}
+
+#endif // SMP_X86
+
+static const t_Noyaux NOYAUX[] = {
+    {JEU_SCALAIRE, "scalaire", minLigneGenerique, maxLigneGenerique, minMaxLigneGenerique,
+     remplirSiNulGenerique, seuillerLigneGenerique, compacterSeuilGenerique, differenceLigneGenerique,
+     marquerInferieursGenerique},
+    {JEU_GENERIQUE, "generique", minLigneGenerique, maxLigneGenerique, minMaxLigneGenerique,
+     remplirSiNulGenerique, seuillerLigneGenerique, compacterSeuilGenerique, differenceLigneGenerique,
+     marquerInferieursGenerique},
+#ifdef SMP_X86
+    {JEU_SSE2, "sse2", minLigneSse2, maxLigneSse2, minMaxLigneSse2,
+     remplirSiNulSse2, seuillerLigneSse2, compacterSeuilSse2, differenceLigneSse2,
+     marquerInferieursSse2},
+    {JEU_AVX2, "avx2", minLigneAvx2, maxLigneAvx2, minMaxLigneAvx2,
+     remplirSiNulAvx2, seuillerLigneAvx2, compacterSeuilAvx2, differenceLigneAvx2,
+     marquerInferieursAvx2},
+    {JEU_AVX512, "avx512", minLigneAvx512, maxLigneAvx512, minMaxLigneAvx512,
+     remplirSiNulAvx512, seuillerLigneAvx512, compacterSeuilAvx512, differenceLigneAvx512,
+     marquerInferieursAvx512},
+#endif
+};
+
+/**
+ * @brief Renvoie le jeu d'instructions le plus performant pris en charge par le
+ *        processeur (et le système) courant, lu par CPUID.
+ */
+t_JeuInstructions meilleurJeu() {
+#ifdef SMP_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512f"))
+        return JEU_AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return JEU_AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return JEU_SSE2;
+#endif
+    return JEU_GENERIQUE;
+}
+
+/**
+ * @brief Noyaux du jeu @p jeu, ou nullptr si le processeur ne le prend pas en charge.
+ */
+static const t_Noyaux *trouverNoyaux(const t_JeuInstructions jeu) {
+    if (jeu > meilleurJeu())
+        return nullptr;
+    for (const auto &n: NOYAUX)
+        if (n.jeu == jeu)
+            return &n;
+    return nullptr;
+}
+
+// jeu imposé par choisirNoyaux, nullptr tant qu'aucun ne l'a été
+static std::atomic<const t_Noyaux *> noyauxChoisis{nullptr};
+
+/**
+ * @brief Choisit le jeu de noyaux utilisé par dilatation() et erosion().
+ *
+ * @param jeu Jeu d'instructions souhaité.
+ * @return faux (et aucun changement) si le processeur ne le prend pas en charge.
+ *
+ * @note Permet de comparer les implémentations ou de revenir au code scalaire
+ *       d'origine (JEU_SCALAIRE). Le choix l'emporte sur SMP_NOYAUX.
+ */
+bool choisirNoyaux(const t_JeuInstructions jeu) {
+    const t_Noyaux *n = trouverNoyaux(jeu);
+    if (n == nullptr)
+        return false;
+    noyauxChoisis.store(n, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Jeu de noyaux actif.
+ *
+ * Sans appel à choisirNoyaux, c'est le meilleur jeu disponible, sauf si la
+ * variable d'environnement SMP_NOYAUX désigne un autre jeu (scalaire,
+ * generique, sse2, avx2 ou avx512). Ce choix par défaut est résolu une seule
+ * fois, au premier appel, même si plusieurs threads le font ensemble.
+ */
+const t_Noyaux &noyaux() {
+    if (const t_Noyaux *choisis = noyauxChoisis.load(std::memory_order_acquire))
+        return *choisis;
+    static const t_Noyaux *const parDefaut = [] {
+        const t_Noyaux *n = trouverNoyaux(meilleurJeu());
+        if (const char *demande = std::getenv("SMP_NOYAUX"))
+            for (const auto &candidat: NOYAUX)
+                if (std::strcmp(candidat.nom, demande) == 0 && trouverNoyaux(candidat.jeu) != nullptr)
+                    n = &candidat;
+        return n;
+    }();
+    return *parDefaut;
+}
+
+// pixels nuls auxquels est comparée la partie d'une ligne qui dépasse l'autre
+static const int TAILLE_ZEROS = 1024;
+static const t_Pixel ZEROS[TAILLE_ZEROS] = {};
+
+/**
+ * @brief Différence absolue de deux lignes de largeurs quelconques, dans une
+ *        ligne de @p n pixels : un pixel absent de l'une des lignes vaut 0.
+ *
+ * @param a, na Première ligne et sa largeur (nullptr et 0 si elle est absente).
+ * @param b, nb Seconde ligne, même convention.
+ * @return Bilan des n pixels, positions comptées depuis le début de @p dst.
+ *
+ * @pre na <= n et nb <= n
+ */
+t_DifferenceLigne differenceLignes(t_Pixel *dst, const int n, const t_Pixel *a, const int na, const t_Pixel *b,
+                                   const int nb, const t_Pixel tolerance) {
+    const t_Noyaux &k = noyaux();
+    const int commun = std::min(na, nb), fin = std::max(na, nb);
+    const t_Pixel *longue = na > nb ? a : b;
+    t_DifferenceLigne bilan = k.differenceLigne(dst, a, b, commun, tolerance);
+    bilan.premier = bilan.changes > 0 ? bilan.premier : n;
+    for (int x = commun; x < fin; x += TAILLE_ZEROS) {
+        const t_DifferenceLigne morceau = k.differenceLigne(dst + x, longue + x, ZEROS,
+                                                            std::min(TAILLE_ZEROS, fin - x), tolerance);
+        bilan.somme += morceau.somme;
+        if (morceau.changes > 0) {
+            bilan.changes += morceau.changes;
+            bilan.premier = std::min(bilan.premier, x + morceau.premier);
+            bilan.dernier = x + morceau.dernier;
+        }
+    }
+    memset(dst + fin, 0, n - fin);
+    return bilan;
+}
+
+/**
+ * @brief Minimum (ou maximum) des pixels recouverts par chaque cellule active,
+ *        pour une ligne de sortie dont les lignes d'entrée voisines sont données.
+ *
+ * @param lignes     lignes[dy - dyMin] est la ligne d'entrée décalée de dy par
+ *                   rapport à la ligne traitée, ou nullptr si elle est hors de
+ *                   l'image (ses pixels sont alors ignorés).
+ * @param dyMin      Plus petit décalage vertical des cellules actives.
+ * @param w          Largeur des lignes.
+ * @param decalages  Cellules actives de l'élément structurant.
+ * @param estMaximum vrai pour le maximum, faux pour le minimum.
+ * @param acc        Reçoit les w extrema.
+ */
+void extremumDepuisLignes(const t_Pixel *const *lignes, const int dyMin, const int w,
+                          const std::vector<t_Decalage> &decalages, const bool estMaximum, t_Pixel *acc) {
+    const auto combiner = estMaximum ? noyaux().maxLigne : noyaux().minLigne;
+
+    memset(acc, estMaximum ? 0 : 255, w);
+    for (const auto &d: decalages) {
+        const t_Pixel *source = lignes[d.dy - dyMin];
+        if (source == nullptr)
+            continue;
+        const int xa = std::max(0, -d.dx);
+        const int xb = std::min(w, w - d.dx);
+        if (xa < xb)
+            combiner(acc + xa, source + xa + d.dx, xb - xa);
+    }
+}
+
+/**
+ * @brief Minimum et maximum des lignes @p lignes décalées par chaque cellule
+ *        active, calculés ensemble : chaque ligne source n'est lue qu'une fois.
+ *
+ * Mêmes conventions que extremumDepuisLignes().
+ */
+void extremumsDepuisLignes(const t_Pixel *const *lignes, const int dyMin, const int w,
+                           const std::vector<t_Decalage> &decalages, t_Pixel *accMin, t_Pixel *accMax) {
+    const auto combiner = noyaux().minMaxLigne;
+
+    memset(accMin, 255, w);
+    memset(accMax, 0, w);
+    for (const auto &d: decalages) {
+        const t_Pixel *source = lignes[d.dy - dyMin];
+        if (source == nullptr)
+            continue;
+        const int xa = std::max(0, -d.dx);
+        const int xb = std::min(w, w - d.dx);
+        if (xa < xb)
+            combiner(accMin + xa, accMax + xa, source + xa + d.dx, xb - xa);
+    }
+}
+
+/**
+ * @brief Minimum (ou maximum) des pixels de la ligne @p y recouverts par chaque
+ *        cellule active, pixels hors de l'image ignorés.
+ */
+static void extremumLigne(const t_Image *imgIn, const int y, const std::vector<t_Decalage> &decalages,
+                          const bool estMaximum, t_Pixel *acc) {
+    int dyMin = 0, dyMax = 0;
+    for (const auto &d: decalages) {
+        dyMin = std::min(dyMin, d.dy);
+        dyMax = std::max(dyMax, d.dy);
+    }
+    std::vector<const t_Pixel *> lignes(dyMax - dyMin + 1);
+    for (int dy = dyMin; dy <= dyMax; dy++)
+        lignes[dy - dyMin] = y + dy >= 0 && y + dy < imgIn->h ? imgIn->ligne(y + dy) : nullptr;
+    extremumDepuisLignes(lignes.data(), dyMin, imgIn->w, decalages, estMaximum, acc);
+}
+
+/**
+ * @brief Minimum (ou maximum) de @p imgIn sous les cellules actives, pour les
+ *        lignes [@p y0, @p y1).
+ *
+ * @param imgIn      Image d'entrée.
+ * @param extremum   Image de mêmes dimensions qui reçoit l'extremum de chaque pixel.
+ * @param decalages  Cellules actives de l'élément structurant.
+ * @param estMaximum vrai pour le maximum (érosion), faux pour le minimum (dilatation).
+ *
+ * @pre imgIn != extremum
+ */
+void extremumLignes(const t_Image *imgIn, t_Image *extremum, const std::vector<t_Decalage> &decalages,
+                    const bool estMaximum, const int y0, const int y1) {
+    for (int y = y0; y < y1; y++)
+        extremumLigne(imgIn, y, decalages, estMaximum, extremum->ligne(y));
+}
+
+/**
+ * @brief Érosion ou dilatation des lignes [@p y0, @p y1) de @p imgOut.
+ *
+ * Pour chaque ligne, le minimum (dilatation) ou le maximum (érosion) des lignes
+ * d'entrée décalées par chaque cellule active est accumulé dans un tampon, puis
+ * les pixels dont l'accumulateur vaut 0 reçoivent @p fillColor. Les autres pixels
+ * de @p imgOut ne sont pas modifiés, comme dans la version scalaire.
+ *
+ * @pre imgIn != imgOut
+ * @pre imgIn et imgOut ont les mêmes dimensions
+ * @pre 0 <= y0 <= y1 <= imgIn->h
+ */
+void morphologieLignes(const t_Image *imgIn, t_Image *imgOut, const std::vector<t_Decalage> &decalages,
+                       const bool estErosion, const unsigned int fillColor, const int y0, const int y1) {
+    std::vector<t_Pixel> acc(imgIn->w);
+
+    for (int y = y0; y < y1; y++) {
+        extremumLigne(imgIn, y, decalages, estErosion, acc.data());
+        noyaux().remplirSiNul(imgOut->ligne(y), acc.data(), imgIn->w, (t_Pixel) fillColor);
+    }
+}
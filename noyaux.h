@@ -0,0 +1,62 @@
+//
+// Noyaux vectoriels (SSE2, AVX2, AVX-512) de la morphologie et du seuillage, choisis au démarrage
+// selon le processeur.
+//
+
+#ifndef SMP_TP3_NOYAUX_H
+#define SMP_TP3_NOYAUX_H
+#include <cstdint>
+#include <vector>
+#include "image.h"
+#include "outils.h"
+
+// jeux d'instructions disponibles, du moins au plus performant
+typedef enum {
+    JEU_SCALAIRE,   // boucles pixel par pixel d'origine de outils.cpp
+    JEU_GENERIQUE,  // boucles ligne par ligne en C++ portable
+    JEU_SSE2,
+    JEU_AVX2,
+    JEU_AVX512
+} t_JeuInstructions;
+
+// bilan de la différence d'une ligne : somme des écarts, nombre de pixels dont
+// l'écart dépasse la tolérance, et positions du premier et du dernier d'entre
+// eux (n et -1 s'il n'y en a aucun)
+typedef struct {
+    uint64_t somme;
+    int changes;
+    int premier, dernier;
+} t_DifferenceLigne;
+
+// opérations élémentaires sur des lignes de n pixels
+typedef struct {
+    t_JeuInstructions jeu;
+    const char *nom;
+    void (*minLigne)(t_Pixel *acc, const t_Pixel *src, int n);
+    void (*maxLigne)(t_Pixel *acc, const t_Pixel *src, int n);
+    void (*minMaxLigne)(t_Pixel *accMin, t_Pixel *accMax, const t_Pixel *src, int n); // les deux en une lecture
+    void (*remplirSiNul)(t_Pixel *dst, const t_Pixel *acc, int n, t_Pixel couleur);
+    void (*seuillerLigne)(t_Pixel *dst, const t_Pixel *src, int n, t_Pixel s); // 0 si src < s, 255 sinon ; dst peut valoir src
+    void (*compacterSeuil)(uint64_t *dst, const t_Pixel *src, int n, t_Pixel s);  // bit x à 1 si src[x] < s (binaire.h)
+    t_DifferenceLigne (*differenceLigne)(t_Pixel *dst, const t_Pixel *a, const t_Pixel *b, int n,
+                                         t_Pixel tolerance);                        // dst = |a - b|
+    void (*marquerInferieurs)(uint64_t *dst, const t_Pixel *a, const t_Pixel *b, const t_Pixel *c,
+                              int n);       // bit x de dst mis à 1 si a[x] < min(b[x], c[x]), les autres inchangés
+} t_Noyaux;
+
+const t_Noyaux &noyaux();
+t_JeuInstructions meilleurJeu();
+bool choisirNoyaux(t_JeuInstructions jeu);
+
+t_DifferenceLigne differenceLignes(t_Pixel *dst, int n, const t_Pixel *a, int na, const t_Pixel *b, int nb,
+                                   t_Pixel tolerance);
+
+void extremumDepuisLignes(const t_Pixel *const *lignes, int dyMin, int w, const std::vector<t_Decalage> &decalages,
+                          bool estMaximum, t_Pixel *acc);
+void extremumsDepuisLignes(const t_Pixel *const *lignes, int dyMin, int w, const std::vector<t_Decalage> &decalages,
+                           t_Pixel *accMin, t_Pixel *accMax);
+void extremumLignes(const t_Image *imgIn, t_Image *extremum, const std::vector<t_Decalage> &decalages,
+                    bool estMaximum, int y0, int y1);
+void morphologieLignes(const t_Image *imgIn, t_Image *imgOut, const std::vector<t_Decalage> &decalages,
+                       bool estErosion, unsigned int fillColor, int y0, int y1);
+#endif //SMP_TP3_NOYAUX_H
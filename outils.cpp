@@ -3,7 +3,17 @@
 //
 
 #include "outils.h"
+#include "flux.h"
+#include "instrumentation.h"
+#include "noyaux.h"
+#include "parallele.h"
+#include "planificateur.h"
+#include "reserve.h"
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
 
 /**
  * @brief Applique un seuillage à un niveau sur une image.
@@ -13,29 +23,27 @@
  * autres pixels par 255 (blanc).
  *
  * @param image Pointeur vers la structure de l'image à traiter.
- *              Les dimensions de l'image doivent être inférieures ou égales à TMAX.
  * @param s Seuil de seuillage. Doit être compris entre 0 et 255 inclus.
  *
  * @pre image != nullptr
- * @pre image->w <= TMAX
- * @pre image->h <= TMAX
  * @pre 0 <= s <= 255
  *
  * @note Cette fonction modifie directement les pixels de l'image passée en paramètre.
  */
 void seuillage(t_Image *image, const unsigned int s) {
+    INSTRUMENTER("seuillage");
+    COMPTER_PIXELS((size_t) image->w * image->h);
+    COMPTER_LECTURE((size_t) image->w * image->h);
     const int w = image->w;
     const int h = image->h;
 
-    assert(h <= TMAX && "La hauteur de image doit être <= 800");
-    assert(w <= TMAX && "La largeur de image doit être <= 800");
     assert(s <= 255  && "La valeur du seuil doit respecter : 0 <= s <= 255");
 
-    for (int i = 0; i < h; i++) {
-        for (int j = 0; j < w; j++) {
-            image->im[i][j] = image->im[i][j] < s ? 0 : 255;
-        }
-    }
+    const auto seuillerLigne = noyaux().seuillerLigne;
+    pourBandes(h, 0, 0, [&](const t_Bande &bande) {
+        for (int i = bande.y0; i < bande.y1; i++)
+            seuillerLigne(image->ligne(i), image->ligne(i), w, (t_Pixel) s);
+    });
 }
 
 /**
@@ -66,16 +74,29 @@ void seuillage(t_Image *image, const unsigned int s) {
  * @pre element != nullptr
  * @pre image_sortie->w == image_entree->w
  * @pre image_sortie->h == image_entree->h
- * @pre image_sortie->w <= TMAX
- * @pre image_sortie->h <= TMAX
  * @pre element->w == element->h
  * @pre element->w % 2 == 1
  * @pre 0 <= couleur_remplissage <= 255
  *
  * @note L'image d'entrée n'est pas modifiée. L'image de sortie doit être préalablement
  *       allouée et de même taille que l'image d'entrée.
+ * @note Sauf si le jeu JEU_SCALAIRE est choisi (voir noyaux.h), le calcul est fait
+ *       ligne par ligne par les noyaux vectoriels : un pixel est dilaté si le
+ *       minimum des pixels recouverts vaut 0. La boucle pixel par pixel ci-dessous
+ *       reste la version de référence.
+ * @note L'élément est d'abord décomposé par planifier() (planificateur.h) : un grand
+ *       rectangle plein ou un long segment est traité par l'algorithme de van Herk /
+ *       Gil-Werman, dont le coût par pixel ne dépend pas de sa taille, et un élément
+ *       qui est l'union ou la somme de Minkowski d'éléments plus petits (croix,
+ *       losange, octogone...) est traité comme tel.
+ * @note Un grand disque (rayon d'au moins RAYON_MIN_DISTANCE) est traité par
+ *       dilatationDisque(), en un temps indépendant du rayon, si la
+ *       transformée en distance de l'image est représentable.
  */
 void dilatation(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *element, const unsigned int fillColor = BLACK) {
+    INSTRUMENTER("dilatation");
+    COMPTER_PIXELS((size_t) imgIn->w * imgIn->h);
+    COMPTER_LECTURE((size_t) imgIn->w * imgIn->h);
     const int imgInWidth = imgIn->w;
     const int imgInHeight = imgIn->h;
 
@@ -87,34 +108,46 @@ void dilatation(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructuran
 
     assert(imgOutWidth == imgInWidth && "La largeur de l'image d'entrée et de sortie doivent être égale.");
     assert(imgOutHeight == imgInHeight && "La hauteur de l'image d'entrée et de sortie doivent être égale.");
-    assert(imgOutHeight <= TMAX && "Les hauteurs des images doivent être <= 800");
-    assert(imgOutWidth <= TMAX && "Les largeurs des images doivent être <= 800");
     assert(elementHeight == elementWidth && "L'élément structurant doit être carrée.");
     assert(elementHeight % 2 == 1 && "La taille de l'élément structurant doit être impaire.");
     assert(fillColor <= 255  && "La valeur de la couleur de remplissage doit respecter : 0 <= s <= 255");
 
-    for (int imgY = 0; imgY < imgInHeight; imgY++) {
-        for (int imgX = 0; imgX < imgInWidth; imgX++) {
-            bool overlap = false;
-            for (int elementY = 0; elementY < elementHeight && !overlap; elementY++) {
-                for (int elementX = 0; elementX < elementWidth && !overlap; elementX++) {
-                    const int pixelX = imgX + elementX - element->centreX,
-                            pixelY = imgY + elementY - element->centreY;
-
-                    if (pixelX >= 0 && pixelX < imgInWidth &&
-                        pixelY >= 0 && pixelY < imgInHeight) {
-                        const unsigned int pixel = imgIn->im[pixelY][pixelX],
-                                           el = element->valeurs[elementY][elementX];
-
-                        if (pixel == el && pixel == BLACK)
-                            overlap = true;
+    if (noyaux().jeu != JEU_SCALAIRE) {
+        const std::vector<t_Decalage> decalages = decalagesActifs(element);
+        int rayon;
+        if (estDisque(decalages, &rayon) && rayon >= RAYON_MIN_DISTANCE && distanceRepresentable(imgIn->w, imgIn->h))
+            dilatationDisque(imgIn, imgOut, rayon, fillColor);
+        else
+            executerPlan(imgIn, imgOut, planifier(decalages), false, fillColor);
+        return;
+    }
+
+    // bandes de lignes traitées en parallèle ; le halo de chaque bande couvre les
+    // lignes de l'élément au-dessus et au-dessous de son centre
+    pourBandes(imgInHeight, element->centreY, elementHeight - 1 - element->centreY, [&](const t_Bande &bande) {
+        for (int imgY = bande.y0; imgY < bande.y1; imgY++) {
+            for (int imgX = 0; imgX < imgInWidth; imgX++) {
+                bool overlap = false;
+                for (int elementY = 0; elementY < elementHeight && !overlap; elementY++) {
+                    for (int elementX = 0; elementX < elementWidth && !overlap; elementX++) {
+                        const int pixelX = imgX + elementX - element->centreX,
+                                pixelY = imgY + elementY - element->centreY;
+
+                        if (pixelX >= 0 && pixelX < imgInWidth &&
+                            pixelY >= 0 && pixelY < imgInHeight) {
+                            const unsigned int pixel = imgIn->ligne(pixelY)[pixelX],
+                                               el = element->valeurs[elementY][elementX];
+
+                            if (pixel == el && pixel == BLACK)
+                                overlap = true;
+                        }
                     }
                 }
+                if (overlap)
+                    imgOut->ligne(imgY)[imgX] = fillColor;
             }
-            if (overlap)
-                imgOut->im[imgY][imgX] = fillColor;
         }
-    }
+    });
 }
 
 /**
@@ -143,8 +176,6 @@ void dilatation(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructuran
  *
  * @pre imgOut->w == imgIn->w
  * @pre imgOut->h == imgIn->h
- * @pre imgOut->w <= TMAX
- * @pre imgOut->h <= TMAX
  * @pre element->w == element->h
  * @pre element->w % 2 == 1
  * @pre 0 <= fillColor <= 255
@@ -153,8 +184,17 @@ void dilatation(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructuran
  *       allouée avant l'appel. Seuls les pixels répondant strictement au critère
  *       d'érosion sont définis dans imgOut ; les autres doivent être initialisés
  *       par l'appelant si nécessaire.
+ * @note Sauf si le jeu JEU_SCALAIRE est choisi (voir noyaux.h), le calcul est fait
+ *       ligne par ligne par les noyaux vectoriels : un pixel est érodé si le
+ *       maximum des pixels recouverts vaut 0.
+ * @note L'élément est d'abord décomposé par planifier() (planificateur.h), comme
+ *       pour la dilatation ; un grand disque est traité par erosionDisque(),
+ *       si la transformée en distance de l'image est représentable.
  */
 void erosion(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *element, unsigned int fillColor = BLACK) {
+    INSTRUMENTER("erosion");
+    COMPTER_PIXELS((size_t) imgIn->w * imgIn->h);
+    COMPTER_LECTURE((size_t) imgIn->w * imgIn->h);
     const int imgInWidth = imgIn->w;
     const int imgInHeight = imgIn->h;
 
@@ -166,34 +206,46 @@ void erosion(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *
 
     assert(imgOutWidth == imgInWidth && "La largeur de l'image d'entrée et de sortie doivent être égale.");
     assert(imgOutHeight == imgInHeight && "La hauteur de l'image d'entrée et de sortie doivent être égale.");
-    assert(imgOutHeight <= TMAX && "Les hauteurs des images doivent être <= 800");
-    assert(imgOutWidth <= TMAX && "Les largeurs des images doivent être <= 800");
     assert(elementHeight == elementWidth && "L'élément structurant doit être carrée.");
     assert(elementHeight % 2 == 1 && "La taille de l'élément structurant doit être impaire.");
     assert(fillColor <= 255  && "La valeur de la couleur de remplissage doit respecter : 0 <= s <= 255");
 
-    for (int imgY = 0; imgY < imgInHeight; imgY++) {
-        for (int imgX = 0; imgX < imgInWidth; imgX++) {
-            bool overlap = true;
-            for (int elementY = 0; elementY < elementHeight && overlap; elementY++) {
-                for (int elementX = 0; elementX < elementWidth && overlap; elementX++) {
-                    const int pixelX = imgX + elementX - element->centreX,
-                            pixelY = imgY + elementY - element->centreY;
-
-                    if (pixelX >= 0 && pixelX < imgInWidth &&
-                        pixelY >= 0 && pixelY < imgInHeight) {
-                        const unsigned int pixel = imgIn->im[pixelY][pixelX],
-                                           el = element->valeurs[elementY][elementX];
-
-                        if (el == BLACK)
-                            overlap = (pixel == BLACK);
-                        }
+    if (noyaux().jeu != JEU_SCALAIRE) {
+        const std::vector<t_Decalage> decalages = decalagesActifs(element);
+        int rayon;
+        if (estDisque(decalages, &rayon) && rayon >= RAYON_MIN_DISTANCE && distanceRepresentable(imgIn->w, imgIn->h))
+            erosionDisque(imgIn, imgOut, rayon, fillColor);
+        else
+            executerPlan(imgIn, imgOut, planifier(decalages), true, fillColor);
+        return;
+    }
+
+    // bandes de lignes traitées en parallèle ; le halo de chaque bande couvre les
+    // lignes de l'élément au-dessus et au-dessous de son centre
+    pourBandes(imgInHeight, element->centreY, elementHeight - 1 - element->centreY, [&](const t_Bande &bande) {
+        for (int imgY = bande.y0; imgY < bande.y1; imgY++) {
+            for (int imgX = 0; imgX < imgInWidth; imgX++) {
+                bool overlap = true;
+                for (int elementY = 0; elementY < elementHeight && overlap; elementY++) {
+                    for (int elementX = 0; elementX < elementWidth && overlap; elementX++) {
+                        const int pixelX = imgX + elementX - element->centreX,
+                                pixelY = imgY + elementY - element->centreY;
+
+                        if (pixelX >= 0 && pixelX < imgInWidth &&
+                            pixelY >= 0 && pixelY < imgInHeight) {
+                            const unsigned int pixel = imgIn->ligne(pixelY)[pixelX],
+                                               el = element->valeurs[elementY][elementX];
+
+                            if (el == BLACK)
+                                overlap = (pixel == BLACK);
+                            }
+                    }
                 }
+                if (overlap)
+                    imgOut->ligne(imgY)[imgX] = fillColor;
             }
-            if (overlap)
-                imgOut->im[imgY][imgX] = fillColor;
         }
-    }
+    });
 }
 
 /**
@@ -224,17 +276,20 @@ void erosion(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *
  *
  * @pre imgOut->w == imgIn->w
  * @pre imgOut->h == imgIn->h
- * @pre imgOut->w <= TMAX
- * @pre imgOut->h <= TMAX
  * @pre element->w == element->h
  * @pre element->w % 2 == 1
  * @pre 0 <= fillColor <= 255
  *
- * @note Une image temporaire est allouée pour stocker le résultat de l’érosion.
- *       Cette image est libérée automatiquement avant la fin de la fonction.
+ * @note Une image temporaire est empruntée à la réserve (reserve.h) pour stocker
+ *       le résultat de l’érosion, puis rendue avant la fin de la fonction.
+ *       Pour un élément traité cellule par cellule, l'érosion est enchaînée
+ *       ligne à ligne avec la dilatation (voir flux.h) et aucune image n'est allouée.
  * @note L’image d’entrée n’est jamais modifiée.
  */
 void ouverture(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *element, unsigned int fillColor = BLACK) {
+    INSTRUMENTER("ouverture");
+    COMPTER_PIXELS((size_t) imgIn->w * imgIn->h);
+    COMPTER_LECTURE((size_t) imgIn->w * imgIn->h);
     const int imgInWidth = imgIn->w;
     const int imgInHeight = imgIn->h;
 
@@ -246,19 +301,24 @@ void ouverture(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant
 
     assert(imgOutWidth == imgInWidth && "La largeur de l'image d'entrée et de sortie doivent être égale.");
     assert(imgOutHeight == imgInHeight && "La hauteur de l'image d'entrée et de sortie doivent être égale.");
-    assert(imgOutHeight <= TMAX && "Les hauteurs des images doivent être <= 800");
-    assert(imgOutWidth <= TMAX && "Les largeurs des images doivent être <= 800");
     assert(elementHeight == elementWidth && "L'élément structurant doit être carrée.");
     assert(elementHeight % 2 == 1 && "La taille de l'élément structurant doit être impaire.");
     assert(fillColor <= 255  && "La valeur de la couleur de remplissage doit respecter : 0 <= s <= 255");
 
-    auto imgEroded = createImage(imgIn->h, imgIn->w, WHITE);
+    // petit élément : les deux opérations sont enchaînées ligne à ligne, sans image intermédiaire
+    if (noyaux().jeu != JEU_SCALAIRE) {
+        const t_Plan plan = planifier(decalagesActifs(element));
+        if (plan.type == ETAPE_DIRECTE) {
+            ouvertureFlux(imgIn, imgOut, plan.decalages, fillColor);
+            return;
+        }
+    }
 
-    erosion(imgIn, imgEroded, element, fillColor);
+    t_ImageEmpruntee imgEroded(emprunterImage(imgIn->h, imgIn->w, WHITE));
 
-    dilatation(imgEroded, imgOut, element, fillColor);
+    erosion(imgIn, imgEroded.get(), element, fillColor);
 
-    delete imgEroded;
+    dilatation(imgEroded.get(), imgOut, element, fillColor);
 }
 
 /**
@@ -292,17 +352,21 @@ void ouverture(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant
  *
  * @pre imgOut->w == imgIn->w
  * @pre imgOut->h == imgIn->h
- * @pre imgOut->w <= TMAX
- * @pre imgOut->h <= TMAX
  * @pre element->w == element->h
  * @pre element->w % 2 == 1
  * @pre 0 <= fillColor <= 255
  *
- * @note Une image temporaire est allouée pour stocker le résultat de la
- *       dilatation intermédiaire, puis libérée avant la fin de la fonction.
+ * @note Une image temporaire est empruntée à la réserve (reserve.h) pour stocker
+ *       le résultat de la dilatation intermédiaire, puis rendue avant la fin de
+ *       la fonction.
+ *       Pour un élément traité cellule par cellule, la dilatation est enchaînée
+ *       ligne à ligne avec l'érosion (voir flux.h) et aucune image n'est allouée.
  * @note L’image d’entrée n’est jamais modifiée.
  */
 void fermeture(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *element, unsigned int fillColor = BLACK) {
+    INSTRUMENTER("fermeture");
+    COMPTER_PIXELS((size_t) imgIn->w * imgIn->h);
+    COMPTER_LECTURE((size_t) imgIn->w * imgIn->h);
     const int imgInWidth = imgIn->w;
     const int imgInHeight = imgIn->h;
 
@@ -314,19 +378,24 @@ void fermeture(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant
 
     assert(imgOutWidth == imgInWidth && "La largeur de l'image d'entrée et de sortie doivent être égale.");
     assert(imgOutHeight == imgInHeight && "La hauteur de l'image d'entrée et de sortie doivent être égale.");
-    assert(imgOutHeight <= TMAX && "Les hauteurs des images doivent être <= 800");
-    assert(imgOutWidth <= TMAX && "Les largeurs des images doivent être <= 800");
     assert(elementHeight == elementWidth && "L'élément structurant doit être carrée.");
     assert(elementHeight % 2 == 1 && "La taille de l'élément structurant doit être impaire.");
     assert(fillColor <= 255  && "La valeur de la couleur de remplissage doit respecter : 0 <= s <= 255");
 
-    auto imgDilated = createImage(imgIn->h, imgIn->w, WHITE);
+    // petit élément : les deux opérations sont enchaînées ligne à ligne, sans image intermédiaire
+    if (noyaux().jeu != JEU_SCALAIRE) {
+        const t_Plan plan = planifier(decalagesActifs(element));
+        if (plan.type == ETAPE_DIRECTE) {
+            fermetureFlux(imgIn, imgOut, plan.decalages, fillColor);
+            return;
+        }
+    }
 
-    dilatation(imgIn, imgDilated, element, fillColor);
+    t_ImageEmpruntee imgDilated(emprunterImage(imgIn->h, imgIn->w, WHITE));
 
-    erosion(imgDilated, imgOut, element, fillColor);
+    dilatation(imgIn, imgDilated.get(), element, fillColor);
 
-    delete imgDilated;
+    erosion(imgDilated.get(), imgOut, element, fillColor);
 }
 
 
@@ -336,9 +405,10 @@ void fermeture(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant
  * Cette fonction alloue une nouvelle structure `t_Image` sur le tas et initialise
  * tous ses pixels à la valeur de fond spécifiée. L'image créée est de dimensions
  * @p h x @p w et peut être utilisée pour des opérations de traitement d'image.
+ * Seul le bloc réellement nécessaire (h lignes de stride octets) est alloué.
  *
- * @param h Hauteur de l'image à créer. Doit être inférieure ou égale à TMAX.
- * @param w Largeur de l'image à créer. Doit être inférieure ou égale à TMAX.
+ * @param h Hauteur de l'image à créer.
+ * @param w Largeur de l'image à créer.
  * @param backgroundColor Valeur du pixel de fond pour initialiser l'image.
  *                     Doit être comprise entre 0 et 255 inclus.
  *
@@ -346,26 +416,22 @@ void fermeture(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant
  *         L'image est allouée dynamiquement et doit être libérée avec `delete`
  *         pour éviter les fuites mémoire.
  *
- * @pre h <= TMAX
- * @pre w <= TMAX
  * @pre 0 <= couleur_fond <= 255
  *
  * @note Tous les pixels de l'image sont initialisés à @p couleur_fond.
- * @note La mémoire pour la structure et le tableau interne est allouée sur le tas.
+ * @note La mémoire pour la structure et le tableau interne est allouée sur le tas ;
+ *       le tableau des pixels est libéré par le destructeur de `t_Image`.
  */
 t_Image * createImage(const unsigned int h, const unsigned int w, const unsigned int backgroundColor) {
-    assert(h <= TMAX && "Les hauteurs des images doivent être <= 800");
-    assert(w <= TMAX && "Les largeurs des images doivent être <= 800");
     assert(backgroundColor <= 255  && "La valeur de la couleur de remplissage doit respecter : 0 <= s <= 255");
 
-    auto image = new t_Image();
-
-    image->h = h;
-    image->w = w;
+    INSTRUMENTER("createImage");
+    auto image = new t_Image(h, w);
+    COMPTER_PIXELS((size_t) image->w * image->h);
+    COMPTER_ALLOCATION((size_t) image->h * image->stride);
 
     for (int i = 0; i < image->h; i++)
-        for (int j = 0; j < image->w; j++)
-            image->im[i][j] = backgroundColor;
+        memset(image->ligne(i), backgroundColor, image->w);
 
     return image;
 }
@@ -381,8 +447,8 @@ t_Image * createImage(const unsigned int h, const unsigned int w, const unsigned
  * ou l’érosion. Le centre (centreX, centreY) représente la position qui sera
  * alignée avec le pixel traité lors du parcours de l’image.
  *
- * @param h Hauteur de l’élément structurant. Doit être inférieure ou égale à TMAX.
- * @param w Largeur de l’élément structurant. Doit être inférieure ou égale à TMAX.
+ * @param h Hauteur de l’élément structurant.
+ * @param w Largeur de l’élément structurant.
  * @param centreX Position du centre sur l’axe horizontal (0 <= centreX < w).
  * @param centreY Position du centre sur l’axe vertical   (0 <= centreY < h).
  * @param backgroundColor Valeur utilisée pour initialiser l’ensemble des cellules
@@ -392,8 +458,6 @@ t_Image * createImage(const unsigned int h, const unsigned int w, const unsigned
  *         L’objet est alloué dynamiquement et doit être libéré avec `delete`
  *         pour éviter les fuites mémoire.
  *
- * @pre h <= TMAX
- * @pre w <= TMAX
  * @pre 0 <= couleur_fond <= 255
  * @pre centreX < w
  * @pre centreY < h
@@ -403,25 +467,41 @@ t_Image * createImage(const unsigned int h, const unsigned int w, const unsigned
  */
 t_ElementStructurant * createElement(const unsigned int h, const unsigned int w, const unsigned int centreX,
     const unsigned int centreY, const unsigned int backgroundColor) {
-    assert(h <= TMAX && "Les hauteurs des images doivent être <= 800");
-    assert(w <= TMAX && "Les largeurs des images doivent être <= 800");
     assert(backgroundColor <= 255  && "La valeur de la couleur de remplissage doit respecter : 0 <= s <= 255");
     assert(centreY < h && "L'ordonnée du centre doit être < à la hauteur de l'élément structurant");
     assert(centreX < w && "L'abscisse du centre doit être < à la largeur de l'élément structurant");
 
+    INSTRUMENTER("createElement");
+    COMPTER_ALLOCATION(sizeof(t_ElementStructurant) + (size_t) h * w);
     auto element_structurant = new t_ElementStructurant();
     element_structurant->h = h;
     element_structurant->w = w;
     element_structurant->centreX = centreX;
     element_structurant->centreY = centreY;
-
-    for (int i = 0; i < element_structurant->h; i++)
-        for (int j = 0; j < element_structurant->w; j++)
-            element_structurant->valeurs[i][j] = backgroundColor;
+    element_structurant->valeurs.w = w;
+    element_structurant->valeurs.cases.assign((size_t) h * w, backgroundColor);
 
     return element_structurant;
 }
 
+/**
+ * @brief Liste les cellules actives (BLACK) d'un élément structurant.
+ *
+ * @param element Élément structurant.
+ * @return Décalages (dx, dy) de chaque cellule active par rapport au centre
+ *         (centreX, centreY), dans l'ordre de parcours ligne par ligne.
+ */
+std::vector<t_Decalage> decalagesActifs(const t_ElementStructurant *element) {
+    INSTRUMENTER("decalagesActifs");
+    COMPTER_LECTURE((size_t) element->w * element->h);
+    std::vector<t_Decalage> decalages;
+    for (int ey = 0; ey < element->h; ey++)
+        for (int ex = 0; ex < element->w; ex++)
+            if (element->valeurs[ey][ex] == BLACK)
+                decalages.push_back({ex - element->centreX, ey - element->centreY});
+    return decalages;
+}
+
 /**
  * @brief Calcule la différence absolue entre deux images pixel par pixel.
  *
@@ -436,7 +516,7 @@ t_ElementStructurant * createElement(const unsigned int h, const unsigned int w,
  * la largeur maximale et la hauteur maximale des deux images. Dans les zones
  * où une seule image possède un pixel (l'autre étant plus petite), la différence
  * est calculée par rapport à la valeur 0, ce qui revient à recopier l’intensité
- * du pixel existant.
+ * du pixel existant (les pixels qu'aucune des deux images ne couvre valent 0).
  *
  * Cette opération permet notamment :
  * - de mettre en évidence les changements entre deux images,
@@ -463,57 +543,87 @@ t_ElementStructurant * createElement(const unsigned int h, const unsigned int w,
  */
 
 void difference(const t_Image* img1, const t_Image* img2, t_Image* sortie) {
-    //Teste si les deux images sont de même taille
-    if ((img1->w == img2->w) && (img1->h == img2->h)){
-        //Initialisation des dimensions de l'image
-        sortie->w = img1->w;
-        sortie->h = img1->h;
-        //Double boucle pour calculer la différence en valeur absolue
-        for (int i = 0 ; i < (img1->w) ; i++){
-            for (int j = 0 ; j < (img1->h) ; j++){
-                sortie->im[i][j] = abs((int)img1->im[i][j]-(int)img2->im[i][j]);
-            }
-        }
+    difference(img1, img2, sortie, nullptr);
+}
+
+/**
+ * @brief Différence absolue de deux images (voir ci-dessus) et son bilan,
+ *        calculés ensemble en une seule lecture des images.
+ *
+ * Les lignes sont parcourues dans l'ordre de la mémoire et traitées par les
+ * noyaux vectoriels (voir noyaux.h) ; les bandes de lignes sont réparties
+ * entre les threads, chacune avec son bilan partiel.
+ *
+ * @param sortie    Image de sortie, ou nullptr si seul le bilan est demandé ;
+ *                  elle peut être img1 ou img2.
+ * @param bilan     Reçoit le bilan (voir t_BilanDifference), ou nullptr.
+ * @param tolerance Un pixel est compté comme changé si son écart la dépasse.
+ *
+ * @pre 0 <= tolerance <= 255
+ */
+void difference(const t_Image* img1, const t_Image* img2, t_Image* sortie, t_BilanDifference *bilan,
+                const unsigned int tolerance) {
+    //sortie confondue avec une entrée que allouer déplacerait (autre taille, ou
+    //vue sur un bloc externe) : le calcul passe par une image temporaire
+    if ((sortie == img1 || sortie == img2)
+        && (sortie->w != std::max(img1->w, img2->w) || sortie->h != std::max(img1->h, img2->h)
+            || sortie->capaciteAllouee() == 0)) {
+        t_Image temporaire;
+        difference(img1, img2, &temporaire, bilan, tolerance);
+        *sortie = std::move(temporaire);
+        return;
     }
-    else{
-        //Définition des objets servant à déterminer les dimensions de l'image de sortie
-        const t_Image* maxi_w;
-        const t_Image* maxi_h;
-        const t_Image* mini_w;
-        const t_Image* mini_h;
-        //Tests pour déterminer les dimensions de l'image de sortie
-        if (img1->w>img2->w){
-            maxi_w = img1;
-            mini_w = img2;
-        }
-        else {
-            maxi_w = img2;
-            mini_w = img1;
-        }
-        if (img1->h>img2->h){
-            maxi_h = img1;
-            mini_h = img2;
-        }
-        else{
-            maxi_h = img2;
-            mini_h = img1;
-        }
-        //Attribution de la taille de l'image de sortie
-        sortie->w = maxi_w->w;
-        sortie->h = maxi_h->h;
-        //Double boucle qui permet de faire le calcul des différences en valeur absolue
-        for (int i=0 ; i<maxi_w->w ; i++){
-            for (int j=0 ; j<maxi_h->h ; j++){
-                if (i < mini_w->w && j< mini_h->h){
-                    sortie->im[i][j]=abs((int)img1->im[i][j]-(int)img2->im[i][j]);
-                }
-                else if (i < maxi_w->w){
-                    sortie->im[i][j]=abs((int)maxi_w->im[i][j]-0);
-                }
-                else{
-                    sortie->im[i][j]=abs((int)maxi_h->im[i][j]-0);
-                }
+    INSTRUMENTER("difference");
+    COMPTER_LECTURE((size_t) img1->w * img1->h + (size_t) img2->w * img2->h);
+    COMPTER_PIXELS((size_t) (img1->w > img2->w ? img1->w : img2->w) * (img1->h > img2->h ? img1->h : img2->h));
+    assert(tolerance <= 255 && "La tolérance doit respecter : 0 <= tolerance <= 255");
+    //Attribution de la taille de l'image de sortie
+    const int w = img1->w > img2->w ? img1->w : img2->w;
+    const int h = img1->h > img2->h ? img1->h : img2->h;
+    if (sortie != nullptr)
+        sortie->allouer(h, w);
+
+    //Chaque bande calcule ses lignes et leur bilan ; un pixel absent de l'une
+    //des deux images vaut 0
+    const std::vector<t_Bande> bandes = decouperBandes(h, 0, 0);
+    std::vector<t_BilanDifference> partiels(bandes.size());
+    executerTaches((int) bandes.size(), [&](const int k) {
+        t_BilanDifference &partiel = partiels[k];
+        partiel = {0, 0, w, h, -1, -1};
+        std::vector<t_Pixel> brouillon(sortie == nullptr ? w : 0);
+        for (int y = bandes[k].y0; y < bandes[k].y1; y++) {
+            const bool dans1 = y < img1->h, dans2 = y < img2->h;
+            const t_DifferenceLigne ligne = differenceLignes(
+                    sortie != nullptr ? sortie->ligne(y) : brouillon.data(), w,
+                    dans1 ? img1->ligne(y) : nullptr, dans1 ? img1->w : 0,
+                    dans2 ? img2->ligne(y) : nullptr, dans2 ? img2->w : 0, (t_Pixel) tolerance);
+            partiel.somme += ligne.somme;
+            if (ligne.changes > 0) {
+                partiel.changes += ligne.changes;
+                partiel.x0 = std::min(partiel.x0, ligne.premier);
+                partiel.x1 = std::max(partiel.x1, ligne.dernier);
+                partiel.y0 = std::min(partiel.y0, y);
+                partiel.y1 = y;
             }
         }
+    });
+    if (bilan == nullptr)
+        return;
+
+    *bilan = {0, 0, w, h, -1, -1};
+    for (const auto &partiel: partiels) {
+        bilan->somme += partiel.somme;
+        bilan->changes += partiel.changes;
+        bilan->x0 = std::min(bilan->x0, partiel.x0);
+        bilan->y0 = std::min(bilan->y0, partiel.y0);
+        bilan->x1 = std::max(bilan->x1, partiel.x1);
+        bilan->y1 = std::max(bilan->y1, partiel.y1);
+    }
+    //bornes incluses pendant le calcul, exclues dans le bilan
+    if (bilan->changes == 0) {
+        bilan->x0 = bilan->y0 = bilan->x1 = bilan->y1 = 0;
+    } else {
+        bilan->x1++;
+        bilan->y1++;
     }
 }
@@ -4,24 +4,137 @@
 
 #ifndef SMP_TP3_OUTILS_H
 #define SMP_TP3_OUTILS_H
+#include <cstdint>
+#include <vector>
 #include "image.h"
 
 #define BLACK 0
 #define WHITE 255
 
+// cellules d'un élément structurant, rangées ligne par ligne et lues comme une
+// matrice : valeurs[i][j] est la cellule de la ligne i et de la colonne j
+struct t_Cellules {
+    int w = 0;
+    std::vector<unsigned char> cases;
+
+    unsigned char *operator[](int i) { return cases.data() + (size_t) i * w; }
+    const unsigned char *operator[](int i) const { return cases.data() + (size_t) i * w; }
+};
+
 typedef struct {
     int w, h;
     int centreX, centreY;
-    t_MatEnt valeurs;
+    t_Cellules valeurs;
 } t_ElementStructurant;
 
+// décalage d'une cellule active (BLACK) d'un élément structurant par rapport à son centre
+typedef struct {
+    int dx, dy;
+} t_Decalage;
+
+std::vector<t_Decalage> decalagesActifs(const t_ElementStructurant *element);
+bool estDisque(const std::vector<t_Decalage> &decalages, int *rayon);
+
+// à partir de ce rayon, un disque est traité par seuillage de la transformée en
+// distance, dont le coût ne dépend pas du rayon, plutôt que par son plan, si
+// l'image n'est pas trop grande pour elle (voir distanceRepresentable)
+#define RAYON_MIN_DISTANCE 14
+
+bool distanceRepresentable(int w, int h);
+
+// carte de distances d'une image, une valeur par pixel rangée ligne par ligne
+typedef struct {
+    int w, h;
+    std::vector<uint32_t> d;
+} t_CarteDistance;
+
+// calcul automatique du seuil à partir de l'histogramme (seuils.cpp)
+typedef enum {
+    SEUIL_OTSU,         // variance inter-classes maximale : histogrammes à deux modes
+    SEUIL_TRIANGLE      // distance au triangle pic-queue : histogrammes à un mode
+} t_MethodeSeuil;
+
 void seuillage(t_Image *image, unsigned int s);
+void histogramme(const t_Image *image, uint64_t histo[256]);
+unsigned int seuilAutomatique(const uint64_t histo[256], t_MethodeSeuil methode = SEUIL_OTSU);
+unsigned int seuillageAutomatique(t_Image *image, t_MethodeSeuil methode = SEUIL_OTSU);
 void dilatation(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *element, unsigned int fillColor);
 void erosion(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *element, unsigned int fillColor);
 void ouverture(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *element, unsigned int fillColor);
 void fermeture(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *element, unsigned int fillColor);
 void difference(const t_Image* img1, const t_Image* img2, t_Image* sortie);
 
+// bilan d'une différence, calculé dans la même passe qu'elle : somme des écarts
+// absolus, nombre de pixels dont l'écart dépasse la tolérance et rectangle
+// [x0, x1) x [y0, y1) qui les contient (tout à 0 s'il n'y en a aucun)
+typedef struct {
+    uint64_t somme;
+    uint64_t changes;
+    int x0, y0, x1, y1;
+} t_BilanDifference;
+
+void difference(const t_Image* img1, const t_Image* img2, t_Image* sortie, t_BilanDifference *bilan,
+                unsigned int tolerance = 0);
+
+// transformées en distance (distance.cpp) et opérateurs par disque en temps indépendant du rayon
+void distanceEuclidienne(const t_Image *imgIn, t_CarteDistance *carte);
+void distanceChanfrein(const t_Image *imgIn, t_CarteDistance *carte);
+void dilatationDisque(const t_Image *imgIn, t_Image *imgOut, unsigned int rayon, unsigned int fillColor);
+void erosionDisque(const t_Image *imgIn, t_Image *imgOut, unsigned int rayon, unsigned int fillColor);
+
+// gradients, chapeaux haut-de-forme et contour en une passe (gradients.cpp)
+typedef enum {
+    GRADIENT_INTERNE,       // image - érosion : bord intérieur des objets
+    GRADIENT_EXTERNE,       // dilatation - image : bord extérieur
+    GRADIENT_SYMETRIQUE     // dilatation - érosion : les deux
+} t_TypeGradient;
+
+void gradient(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *element,
+              t_TypeGradient type = GRADIENT_SYMETRIQUE);
+void contour(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *element);
+void chapeauBlanc(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *element);
+void chapeauNoir(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *element);
+
+// transformée en tout ou rien par table de voisinage 3x3, amincissement et
+// squelette (amincissement.cpp)
+void toutOuRien(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *touche,
+                const t_ElementStructurant *manque);
+uint64_t amincissement(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *touche,
+                       const t_ElementStructurant *manque, int iterationsMax = 0);
+uint64_t squelette(const t_Image *imgIn, t_Image *imgOut, int iterationsMax = 0);
+
+// étiquetage des composantes connexes (composantes.cpp) : une étiquette par
+// pixel rangée ligne par ligne, 0 pour le fond
+typedef struct {
+    int w, h;
+    std::vector<uint32_t> e;
+} t_Etiquettes;
+
+// mesures d'une composante : nombre de pixels, rectangle englobant
+// [x0, x1) x [y0, y1) et centre de gravité
+typedef struct {
+    uint64_t aire;
+    int x0, y0, x1, y1;
+    double cx, cy;
+} t_Composante;
+
+typedef enum {
+    CONNEXITE_4,    // voisins par un côté
+    CONNEXITE_8     // voisins par un côté ou un coin
+} t_Connexite;
+
+int etiqueter(const t_Image *image, t_Etiquettes *etiquettes, std::vector<t_Composante> *composantes,
+              t_Connexite connexite = CONNEXITE_8);
+
+// reconstruction géodésique, remplissage des trous et suppression des objets
+// qui touchent le bord (reconstruction.cpp), en binaire comme en niveaux de gris
+void reconstructionDilatation(const t_Image *marqueur, const t_Image *masque, t_Image *sortie,
+                              t_Connexite connexite = CONNEXITE_8);
+void reconstructionErosion(const t_Image *marqueur, const t_Image *masque, t_Image *sortie,
+                           t_Connexite connexite = CONNEXITE_8);
+void remplirTrous(const t_Image *imgIn, t_Image *imgOut, t_Connexite connexite = CONNEXITE_8);
+void supprimerBord(const t_Image *imgIn, t_Image *imgOut, t_Connexite connexite = CONNEXITE_8);
+
 t_Image* createImage(unsigned int h = 50, unsigned int w = 50, unsigned int backgroundColor = WHITE);
 t_ElementStructurant* createElement(unsigned int h = 3, unsigned int w = 3, unsigned int centreX = 1, unsigned int centreY = 1, unsigned int backgroundColor = WHITE);
 #endif //SMP_TP3_OUTILS_H
\ No newline at end of file
@@ -0,0 +1,261 @@
+//
+// Exécution parallèle des opérateurs : pool de threads à vol de tâches et
+// découpage des images en bandes de lignes.
+//
+
+#include "parallele.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/*
+ * Les threads du pool dorment jusqu'à ce qu'un lot de tâches soit soumis. Les
+ * tâches du lot (des indices 0..n-1) sont réparties à tour de rôle dans une file
+ * par participant, le thread appelant compris. Chacun vide sa file par l'avant
+ * puis vole les tâches restantes à l'arrière des files des autres : une bande
+ * plus coûteuse que les autres ne laisse pas les threads inoccupés.
+ *
+ * Un seul lot s'exécute à la fois ; un lot soumis depuis une tâche (opérateur
+ * appelé dans un opérateur parallèle) est exécuté en série par le thread qui le
+ * soumet.
+ */
+
+// nombre de bandes par thread : assez pour que le vol équilibre la charge
+static const int BANDES_PAR_THREAD = 4;
+// hauteur minimale d'une bande, en lignes : en deçà, le halo relu coûte trop cher
+static const int HAUTEUR_MIN_BANDE = 16;
+
+struct t_File {
+    std::mutex verrou;
+    std::deque<int> taches;
+};
+
+class t_Pool {
+public:
+    explicit t_Pool(int n);
+    ~t_Pool();
+
+    int taille() const { return (int) files.size(); }
+    void executer(int n, const std::function<void(int)> &tache);
+
+private:
+    std::vector<std::thread> threads;
+    std::vector<std::unique_ptr<t_File> > files;
+
+    std::mutex verrou;
+    std::condition_variable reveil, fin;
+    const std::function<void(int)> *lot = nullptr;
+    unsigned long generation = 0;
+    std::atomic<int> restantes{0};
+    int actifs = 0;
+    bool arret = false;
+
+    bool prendre(int participant, int &indice);
+    void participer(int participant);
+    void boucle(int participant);
+};
+
+// vrai dans une tâche en cours d'exécution : les lots imbriqués sont exécutés en série
+static thread_local bool dansUneTache = false;
+
+t_Pool::t_Pool(const int n) {
+    for (int i = 0; i < n; i++)
+        files.emplace_back(new t_File());
+    for (int i = 1; i < n; i++)
+        threads.emplace_back(&t_Pool::boucle, this, i);
+}
+
+t_Pool::~t_Pool() {
+    {
+        std::lock_guard<std::mutex> garde(verrou);
+        arret = true;
+    }
+    reveil.notify_all();
+    for (auto &t: threads)
+        t.join();
+}
+
+/**
+ * @brief Prend une tâche dans la file du participant, sinon en vole une à
+ *        l'arrière de la file d'un autre.
+ */
+bool t_Pool::prendre(const int participant, int &indice) {
+    const int n = taille();
+    for (int k = 0; k < n; k++) {
+        t_File &file = *files[(participant + k) % n];
+        std::lock_guard<std::mutex> garde(file.verrou);
+        if (file.taches.empty())
+            continue;
+        if (k == 0) {
+            indice = file.taches.front();
+            file.taches.pop_front();
+        } else {
+            indice = file.taches.back();
+            file.taches.pop_back();
+        }
+        return true;
+    }
+    return false;
+}
+
+void t_Pool::participer(const int participant) {
+    dansUneTache = true;
+    int indice;
+    while (prendre(participant, indice)) {
+        (*lot)(indice);
+        if (restantes.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> garde(verrou);
+            fin.notify_all();
+        }
+    }
+    dansUneTache = false;
+}
+
+void t_Pool::boucle(const int participant) {
+    unsigned long vue = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> garde(verrou);
+            reveil.wait(garde, [&] { return arret || generation != vue; });
+            if (arret)
+                return;
+            vue = generation;
+            actifs++;
+        }
+        participer(participant);
+        {
+            std::lock_guard<std::mutex> garde(verrou);
+            actifs--;
+        }
+        fin.notify_all();
+    }
+}
+
+void t_Pool::executer(const int n, const std::function<void(int)> &tache) {
+    static std::mutex unLotALaFois;
+    std::lock_guard<std::mutex> exclusif(unLotALaFois);
+
+    // un thread en retard sur le lot précédent peut prendre une tâche dès
+    // qu'elle est en file : le lot est publié avant
+    {
+        std::lock_guard<std::mutex> garde(verrou);
+        lot = &tache;
+        restantes = n;
+        generation++;
+    }
+    for (int i = 0; i < n; i++) {
+        t_File &file = *files[i % taille()];
+        std::lock_guard<std::mutex> garde(file.verrou);
+        file.taches.push_back(i);
+    }
+    reveil.notify_all();
+
+    participer(0);
+
+    // le lot n'est rendu qu'une fois toutes ses tâches terminées et tous les
+    // threads sortis de participer() : aucun ne peut plus lire lot ensuite
+    std::unique_lock<std::mutex> garde(verrou);
+    fin.wait(garde, [&] { return restantes == 0 && actifs == 0; });
+    lot = nullptr;
+}
+
+static int threadsDemandes = 0;
+static std::unique_ptr<t_Pool> pool;
+static std::mutex verrouPool;
+
+/**
+ * @brief Nombre de threads utilisés par les opérateurs.
+ *
+ * Sauf appel à definirNombreThreads(), c'est la valeur de la variable
+ * d'environnement SMP_THREADS si elle est définie, sinon le nombre de cœurs.
+ */
+int nombreThreads() {
+    std::lock_guard<std::mutex> garde(verrouPool);
+    if (threadsDemandes <= 0) {
+        const char *demande = std::getenv("SMP_THREADS");
+        threadsDemandes = demande != nullptr ? std::atoi(demande) : 0;
+        if (threadsDemandes <= 0)
+            threadsDemandes = std::max(1, (int) std::thread::hardware_concurrency());
+    }
+    return threadsDemandes;
+}
+
+/**
+ * @brief Fixe le nombre de threads utilisés par les opérateurs.
+ *
+ * @param n Nombre de threads, thread appelant compris : 1 pour une exécution
+ *          en série, 0 pour revenir au choix par défaut (voir nombreThreads).
+ *
+ * @pre aucun opérateur n'est en cours d'exécution dans un autre thread
+ */
+void definirNombreThreads(const int n) {
+    std::lock_guard<std::mutex> garde(verrouPool);
+    threadsDemandes = std::max(0, n);
+    pool.reset();
+}
+
+/**
+ * @brief Exécute tache(0), ..., tache(n - 1) sur le pool et attend leur fin.
+ *
+ * Les tâches doivent être indépendantes : leur ordre d'exécution et le thread
+ * qui exécute chacune ne sont pas déterminés.
+ */
+void executerTaches(const int n, const std::function<void(int)> &tache) {
+    const int threads = nombreThreads();
+    if (n <= 1 || threads <= 1 || dansUneTache) {
+        for (int i = 0; i < n; i++)
+            tache(i);
+        return;
+    }
+
+    t_Pool *p;
+    {
+        std::lock_guard<std::mutex> garde(verrouPool);
+        if (pool == nullptr || pool->taille() != threads)
+            pool.reset(new t_Pool(threads));
+        p = pool.get();
+    }
+    p->executer(n, tache);
+}
+
+/**
+ * @brief Découpe les lignes [0, h) en bandes pour les threads disponibles.
+ *
+ * @param h        Hauteur de l'image.
+ * @param haloHaut Lignes lues au-dessus de chaque bande (décalage vertical
+ *                 minimal de l'élément, en valeur absolue).
+ * @param haloBas  Lignes lues au-dessous de chaque bande.
+ * @return Bandes contiguës couvrant [0, h), une seule s'il n'y a qu'un thread.
+ */
+std::vector<t_Bande> decouperBandes(const int h, const int haloHaut, const int haloBas) {
+    const int voulues = nombreThreads() <= 1 ? 1 : nombreThreads() * BANDES_PAR_THREAD;
+    const int n = std::max(1, std::min(voulues, h / HAUTEUR_MIN_BANDE));
+
+    std::vector<t_Bande> bandes;
+    for (int i = 0; i < n; i++) {
+        t_Bande b;
+        b.y0 = (int) ((long long) h * i / n);
+        b.y1 = (int) ((long long) h * (i + 1) / n);
+        b.lectureY0 = std::max(0, b.y0 - haloHaut);
+        b.lectureY1 = std::min(h, b.y1 + haloBas);
+        bandes.push_back(b);
+    }
+    return bandes;
+}
+
+/**
+ * @brief Applique @p traiter à chaque bande de decouperBandes(h, haloHaut,
+ *        haloBas), en parallèle.
+ *
+ * Chaque appel ne doit écrire que les lignes [y0, y1) de sa bande.
+ */
+void pourBandes(const int h, const int haloHaut, const int haloBas,
+                const std::function<void(const t_Bande &)> &traiter) {
+    const std::vector<t_Bande> bandes = decouperBandes(h, haloHaut, haloBas);
+    executerTaches((int) bandes.size(), [&](const int i) { traiter(bandes[i]); });
+}
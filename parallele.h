@@ -0,0 +1,24 @@
+//
+// Exécution parallèle des opérateurs : pool de threads à vol de tâches et
+// découpage des images en bandes de lignes.
+//
+
+#ifndef SMP_TP3_PARALLELE_H
+#define SMP_TP3_PARALLELE_H
+#include <functional>
+#include <vector>
+
+// bande de lignes [y0, y1) à produire ; son calcul lit les lignes
+// [lectureY0, lectureY1) de l'image d'entrée (la bande et son halo, tronqués à l'image)
+typedef struct {
+    int y0, y1;
+    int lectureY0, lectureY1;
+} t_Bande;
+
+int nombreThreads();
+void definirNombreThreads(int n);
+
+void executerTaches(int n, const std::function<void(int)> &tache);
+std::vector<t_Bande> decouperBandes(int h, int haloHaut, int haloBas);
+void pourBandes(int h, int haloHaut, int haloBas, const std::function<void(const t_Bande &)> &traiter);
+#endif //SMP_TP3_PARALLELE_H
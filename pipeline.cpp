@@ -0,0 +1,566 @@
+//
+// Chaînes d'opérateurs déclarées à l'avance puis exécutées ligne à ligne, sans
+// image intermédiaire complète.
+//
+
+#include "pipeline.h"
+#include "chargesauve.h"
+#include "noyaux.h"
+#include "parallele.h"
+#include "planificateur.h"
+#include "reserve.h"
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+/*
+ * Exécution d'un graphe de noeuds (les entrées d'un noeud ont toujours un
+ * indice plus petit que lui) :
+ *
+ * 1. Préparation : les fichiers sont chargés et les dimensions propagées. Une
+ *    dilatation ou une érosion dont l'élément gagne à être décomposé (van Herk,
+ *    composition... voir planificateur.h) est calculée sur l'image complète de
+ *    son entrée, puis traitée comme une source.
+ *
+ * 2. Passe unique sur les lignes : toutes les sorties demandées sont produites
+ *    ensemble, ligne par ligne. Pour produire la ligne y des sorties, chaque
+ *    noeud doit disposer de ses lignes y + haut à y + bas, plage obtenue en
+ *    remontant le graphe (un seuillage ou une différence lit la même ligne que
+ *    lui, une dilatation ou une érosion les lignes y + dyMin à y + dyMax de son
+ *    entrée). Ces lignes vivent dans un tampon circulaire propre au noeud, de
+ *    bas - haut + 1 lignes : un seuillage suivi d'une ouverture ne passe jamais
+ *    par la mémoire centrale, et un noeud lu par deux branches n'est calculé
+ *    qu'une fois.
+ *
+ * La passe est découpée en bandes de lignes parallèles (voir parallele.h) ;
+ * chaque bande a ses propres tampons et recalcule les lignes de son halo. Une
+ * bande n'écrit dans une sortie que ses propres lignes : une cible lue avec un
+ * halo par un autre noeud est calculée dans un tampon circulaire, comme un
+ * noeud intermédiaire, puis recopiée ligne à ligne dans sa sortie (écrire le
+ * halo dans la sortie partagée ferait écrire deux bandes sur les mêmes lignes
+ * pendant que l'une les lit).
+ *
+ * Exécution par bandes (executerParBandes) : pour les images qui ne tiennent
+ * pas en mémoire, rien n'est jamais complet. Les fichiers sont lus ligne à
+ * ligne dans une fenêtre glissante, la passe est faite bande horizontale par
+ * bande horizontale, et les lignes de chaque bande sont écrites dès qu'elles
+ * sont calculées. Aucun noeud n'est matérialisé à la préparation : une
+ * dilatation ou une érosion est toujours calculée ligne à ligne, cellule par
+ * cellule, quel que soit son élément.
+ */
+
+int t_Pipeline::ajouter(const t_Noeud &noeud) {
+    noeuds.push_back(noeud);
+    return (int) noeuds.size() - 1;
+}
+
+static t_Noeud noeudVide(const t_TypeNoeud type, const int entree1 = -1, const int entree2 = -1) {
+    t_Noeud noeud;
+    noeud.type = type;
+    noeud.entrees[0] = entree1;
+    noeud.entrees[1] = entree2;
+    noeud.image = nullptr;
+    noeud.valeur = 0;
+    return noeud;
+}
+
+/**
+ * @brief Déclare une image déjà en mémoire ; elle doit rester valide jusqu'à la
+ *        fin de l'exécution et n'est pas modifiée.
+ */
+int t_Pipeline::source(const t_Image *image) {
+    assert(image != nullptr);
+    t_Noeud noeud = noeudVide(NOEUD_IMAGE);
+    noeud.image = image;
+    return ajouter(noeud);
+}
+
+/**
+ * @brief Déclare une image PGM, chargée seulement à l'exécution.
+ */
+int t_Pipeline::charger(const std::string &nomFichier) {
+    t_Noeud noeud = noeudVide(NOEUD_FICHIER);
+    noeud.fichier = nomFichier;
+    return ajouter(noeud);
+}
+
+/**
+ * @brief Seuillage de @p entree (voir seuillage()).
+ */
+int t_Pipeline::seuiller(const int entree, const unsigned int s) {
+    assert(entree >= 0 && entree < (int) noeuds.size());
+    assert(s <= 255 && "La valeur du seuil doit respecter : 0 <= s <= 255");
+    t_Noeud noeud = noeudVide(NOEUD_SEUILLAGE, entree);
+    noeud.valeur = s;
+    return ajouter(noeud);
+}
+
+/**
+ * @brief Dilatation de @p entree (voir dilatation()) : le résultat est une image
+ *        blanche dont les pixels retenus valent @p fillColor. L'élément est
+ *        recopié et peut être libéré aussitôt.
+ */
+int t_Pipeline::dilater(const int entree, const t_ElementStructurant *element, const unsigned int fillColor) {
+    assert(entree >= 0 && entree < (int) noeuds.size());
+    assert(fillColor <= 255 && "La valeur de la couleur de remplissage doit respecter : 0 <= s <= 255");
+    t_Noeud noeud = noeudVide(NOEUD_DILATATION, entree);
+    noeud.valeur = fillColor;
+    noeud.decalages = decalagesActifs(element);
+    return ajouter(noeud);
+}
+
+/**
+ * @brief Érosion de @p entree (voir erosion()), même convention que dilater().
+ */
+int t_Pipeline::eroder(const int entree, const t_ElementStructurant *element, const unsigned int fillColor) {
+    assert(entree >= 0 && entree < (int) noeuds.size());
+    assert(fillColor <= 255 && "La valeur de la couleur de remplissage doit respecter : 0 <= s <= 255");
+    t_Noeud noeud = noeudVide(NOEUD_EROSION, entree);
+    noeud.valeur = fillColor;
+    noeud.decalages = decalagesActifs(element);
+    return ajouter(noeud);
+}
+
+int t_Pipeline::ouvrir(const int entree, const t_ElementStructurant *element, const unsigned int fillColor) {
+    return dilater(eroder(entree, element, fillColor), element, fillColor);
+}
+
+int t_Pipeline::fermer(const int entree, const t_ElementStructurant *element, const unsigned int fillColor) {
+    return eroder(dilater(entree, element, fillColor), element, fillColor);
+}
+
+/**
+ * @brief Différence absolue de deux noeuds (voir difference()).
+ */
+int t_Pipeline::differencier(const int entree1, const int entree2) {
+    assert(entree1 >= 0 && entree1 < (int) noeuds.size());
+    assert(entree2 >= 0 && entree2 < (int) noeuds.size());
+    return ajouter(noeudVide(NOEUD_DIFFERENCE, entree1, entree2));
+}
+
+/**
+ * @brief Demande l'enregistrement de @p noeud lors de executer().
+ */
+void t_Pipeline::sauver(const int noeud, const std::string &nomFichier, const t_FormatPgm format) {
+    assert(noeud >= 0 && noeud < (int) noeuds.size());
+    sauvegardes.push_back({noeud, nomFichier, format});
+}
+
+static bool estMorphologie(const t_Noeud &noeud) {
+    return noeud.type == NOEUD_DILATATION || noeud.type == NOEUD_EROSION;
+}
+
+// état d'une exécution : images complètes disponibles et dimensions des noeuds.
+// Les lignes d'une image complète ou d'une sortie commencent à la ligne
+// origine du noeud (0, sauf pour les fenêtres et les bandes d'une exécution
+// par bandes).
+struct t_Execution {
+    const std::vector<t_Noeud> &noeuds;
+    std::vector<t_ImageEmpruntee> possedees;
+    std::vector<const t_Image *> completes;
+    std::vector<int> h, w, dyMin, dyMax, origine;
+    std::vector<char> prepare;
+    std::vector<t_LecteurPgm *> lecteurs;   // fichiers lus ligne à ligne (par bandes)
+    bool parBandes;
+    bool ok;
+
+    explicit t_Execution(const std::vector<t_Noeud> &n, const bool parBandes = false)
+        : noeuds(n), possedees(n.size()), completes(n.size(), nullptr), h(n.size(), 0), w(n.size(), 0),
+          dyMin(n.size(), 0), dyMax(n.size(), 0), origine(n.size(), 0), prepare(n.size(), 0),
+          lecteurs(n.size(), nullptr), parBandes(parBandes), ok(true) {
+    }
+
+    ~t_Execution() {
+        for (t_LecteurPgm *lecteur: lecteurs)
+            fermerPgm(lecteur);
+    }
+
+    t_Execution(const t_Execution &) = delete;
+    t_Execution &operator=(const t_Execution &) = delete;
+
+    void preparer(int i);
+    void plages(std::vector<int> &haut, std::vector<int> &bas, int &haloHaut, int &haloBas) const;
+    void passe(const std::vector<int> &cibles, const std::vector<t_Image *> &sorties);
+    bool passeParBandes(const std::vector<int> &cibles, const std::vector<t_EcrivainPgm *> &ecrivains,
+                        int hauteurBande);
+    void bande(const t_Bande &b, const std::vector<int> &haut, const std::vector<int> &bas,
+               const std::vector<t_Image *> &sortie);
+};
+
+/**
+ * @brief Charge les fichiers, calcule les dimensions et matérialise les
+ *        dilatations et érosions qui ne se prêtent pas au calcul ligne à ligne.
+ */
+void t_Execution::preparer(const int i) {
+    if (prepare[i])
+        return;
+    prepare[i] = 1;
+    const t_Noeud &noeud = noeuds[i];
+    for (const int e: noeud.entrees)
+        if (e >= 0)
+            preparer(e);
+
+    switch (noeud.type) {
+        case NOEUD_IMAGE:
+            completes[i] = noeud.image;
+            break;
+        case NOEUD_FICHIER: {
+            bool Ok = false;
+            if (parBandes) {
+                // la fenêtre de lignes est allouée par la passe
+                lecteurs[i] = ouvrirPgm(noeud.fichier, h[i], w[i], Ok);
+                ok = ok && Ok;
+                break;
+            }
+            possedees[i].reset(new t_Image());
+            loadPgm(noeud.fichier, possedees[i].get(), Ok);
+            ok = ok && Ok;
+            completes[i] = possedees[i].get();
+            break;
+        }
+        case NOEUD_DIFFERENCE:
+            h[i] = std::max(h[noeud.entrees[0]], h[noeud.entrees[1]]);
+            w[i] = std::max(w[noeud.entrees[0]], w[noeud.entrees[1]]);
+            break;
+        default:
+            h[i] = h[noeud.entrees[0]];
+            w[i] = w[noeud.entrees[0]];
+            break;
+    }
+    if (completes[i] != nullptr) {
+        h[i] = completes[i]->h;
+        w[i] = completes[i]->w;
+    }
+    for (const auto &d: noeud.decalages) {
+        dyMin[i] = std::min(dyMin[i], d.dy);
+        dyMax[i] = std::max(dyMax[i], d.dy);
+    }
+
+    if (!ok || !estMorphologie(noeud) || parBandes)
+        return;
+    const t_Plan plan = planifier(noeud.decalages);
+    if (plan.type == ETAPE_DIRECTE)
+        return;
+
+    // élément décomposable : calcul sur l'image complète
+    const int e = noeud.entrees[0];
+    t_ImageEmpruntee temporaire;
+    const t_Image *entree = completes[e];
+    if (entree == nullptr) {
+        temporaire.reset(emprunterImage(h[e], w[e]));
+        passe({e}, {temporaire.get()});
+        entree = temporaire.get();
+    }
+    possedees[i].reset(emprunterImage(h[i], w[i], WHITE));
+    int rayon;
+    if (estDisque(noeud.decalages, &rayon) && rayon >= RAYON_MIN_DISTANCE &&
+        distanceRepresentable(w[i], h[i]))
+        (noeud.type == NOEUD_EROSION ? erosionDisque : dilatationDisque)(entree, possedees[i].get(), rayon, noeud.valeur);
+    else
+        executerPlan(entree, possedees[i].get(), plan, noeud.type == NOEUD_EROSION, noeud.valeur);
+    completes[i] = possedees[i].get();
+}
+
+/**
+ * @brief Produit les lignes [b.y0, b.y1) des noeuds cibles (ceux dont sortie
+ *        n'est pas nul), en calculant au fil de l'eau les lignes des noeuds
+ *        intermédiaires. Seules ces lignes des sorties sont écrites.
+ */
+void t_Execution::bande(const t_Bande &b, const std::vector<int> &haut, const std::vector<int> &bas,
+                        const std::vector<t_Image *> &sortie) {
+    const int n = (int) noeuds.size();
+    std::vector<int> actifs;
+    for (int i = 0; i < n; i++)
+        if (haut[i] <= bas[i] && completes[i] == nullptr)
+            actifs.push_back(i);
+
+    // une cible sans halo n'est produite que sur les lignes de la bande, écrites
+    // directement dans sa sortie ; tout autre noeud passe par son tampon
+    std::vector<std::vector<t_Pixel> > anneaux(n);
+    std::vector<int> suivante(n, 0);
+    int largeurMax = 1, hauteurMax = 1;
+    for (const int i: actifs) {
+        if (sortie[i] == nullptr || haut[i] < 0 || bas[i] > 0)
+            anneaux[i].resize((size_t) (bas[i] - haut[i] + 1) * w[i]);
+        suivante[i] = std::max(0, b.y0 + haut[i]);
+        largeurMax = std::max(largeurMax, w[i]);
+        hauteurMax = std::max(hauteurMax, dyMax[i] - dyMin[i] + 1);
+    }
+    std::vector<t_Pixel> acc(largeurMax);
+    std::vector<const t_Pixel *> lignes(hauteurMax);
+
+    auto ligne = [&](const int i, const int r) -> t_Pixel * {
+        if (completes[i] != nullptr)
+            return const_cast<t_Pixel *>(completes[i]->ligne(r - origine[i]));
+        if (anneaux[i].empty())
+            return sortie[i]->ligne(r - origine[i]);
+        return anneaux[i].data() + (size_t) (r % (bas[i] - haut[i] + 1)) * w[i];
+    };
+
+    auto produire = [&](const int i, const int r) {
+        const t_Noeud &noeud = noeuds[i];
+        t_Pixel *dst = ligne(i, r);
+        switch (noeud.type) {
+            case NOEUD_SEUILLAGE: {
+                noyaux().seuillerLigne(dst, ligne(noeud.entrees[0], r), w[i], (t_Pixel) noeud.valeur);
+                break;
+            }
+            case NOEUD_DIFFERENCE: {
+                const int e1 = noeud.entrees[0], e2 = noeud.entrees[1];
+                differenceLignes(dst, w[i], r < h[e1] ? ligne(e1, r) : nullptr, r < h[e1] ? w[e1] : 0,
+                                 r < h[e2] ? ligne(e2, r) : nullptr, r < h[e2] ? w[e2] : 0, 0);
+                break;
+            }
+            case NOEUD_DILATATION:
+            case NOEUD_EROSION: {
+                const int e = noeud.entrees[0];
+                for (int dy = dyMin[i]; dy <= dyMax[i]; dy++)
+                    lignes[dy - dyMin[i]] = r + dy >= 0 && r + dy < h[e] ? ligne(e, r + dy) : nullptr;
+                extremumDepuisLignes(lignes.data(), dyMin[i], w[i], noeud.decalages,
+                                     noeud.type == NOEUD_EROSION, acc.data());
+                memset(dst, WHITE, w[i]);
+                noyaux().remplirSiNul(dst, acc.data(), w[i], (t_Pixel) noeud.valeur);
+                break;
+            }
+            default:
+                break;
+        }
+        if (sortie[i] != nullptr && !anneaux[i].empty() && r >= b.y0 && r < b.y1)
+            memcpy(sortie[i]->ligne(r - origine[i]), dst, w[i]);
+    };
+
+    for (int y = b.y0; y < b.y1; y++)
+        for (const int i: actifs)
+            for (const int fin = std::min(h[i] - 1, y + bas[i]); suivante[i] <= fin; suivante[i]++)
+                produire(i, suivante[i]);
+}
+
+/**
+ * @brief Plages de lignes nécessaires, des cibles (haut = bas = 0) vers les
+ *        sources, et halos des bandes parallèles qui en découlent.
+ */
+void t_Execution::plages(std::vector<int> &haut, std::vector<int> &bas, int &haloHaut, int &haloBas) const {
+    haloHaut = 0;
+    haloBas = 0;
+    for (int i = (int) noeuds.size() - 1; i >= 0; i--) {
+        if (haut[i] > bas[i] || completes[i] != nullptr)
+            continue;
+        haloHaut = std::max(haloHaut, -haut[i]);
+        haloBas = std::max(haloBas, bas[i]);
+        for (const int e: noeuds[i].entrees)
+            if (e >= 0) {
+                haut[e] = std::min(haut[e], haut[i] + dyMin[i]);
+                bas[e] = std::max(bas[e], bas[i] + dyMax[i]);
+            }
+    }
+}
+
+/**
+ * @brief Calcule les noeuds @p cibles (préparés) dans les images @p sorties, déjà
+ *        allouées à leurs dimensions, en une seule passe sur les lignes.
+ */
+void t_Execution::passe(const std::vector<int> &cibles, const std::vector<t_Image *> &sorties) {
+    const int n = (int) noeuds.size();
+    std::vector<int> haut(n, INT_MAX), bas(n, INT_MIN);
+    std::vector<t_Image *> sortie(n, nullptr);
+    int hauteur = 0;
+
+    for (size_t k = 0; k < cibles.size(); k++) {
+        const int c = cibles[k];
+        if (completes[c] != nullptr) {
+            for (int y = 0; y < h[c]; y++)
+                memcpy(sorties[k]->ligne(y), completes[c]->ligne(y), w[c]);
+            continue;
+        }
+        if (sortie[c] != nullptr) {
+            // noeud demandé deux fois : recopié après la passe
+            continue;
+        }
+        haut[c] = std::min(haut[c], 0);
+        bas[c] = std::max(bas[c], 0);
+        sortie[c] = sorties[k];
+        hauteur = std::max(hauteur, h[c]);
+    }
+
+    int haloHaut, haloBas;
+    plages(haut, bas, haloHaut, haloBas);
+    if (hauteur > 0)
+        pourBandes(hauteur, haloHaut, haloBas, [&](const t_Bande &b) { bande(b, haut, bas, sortie); });
+
+    for (size_t k = 0; k < cibles.size(); k++)
+        if (sortie[cibles[k]] != nullptr && sortie[cibles[k]] != sorties[k])
+            for (int y = 0; y < h[cibles[k]]; y++)
+                memcpy(sorties[k]->ligne(y), sortie[cibles[k]]->ligne(y), w[cibles[k]]);
+}
+
+/**
+ * @brief Calcule les noeuds @p cibles (préparés par bandes) bande horizontale
+ *        par bande horizontale de @p hauteurBande lignes, et écrit chaque bande
+ *        dans les fichiers dès qu'elle est calculée.
+ *
+ * Chaque fichier source est lu dans une fenêtre glissante qui contient les
+ * lignes de la bande et celles de son halo ; les lignes du halo du bas sont
+ * gardées pour la bande suivante. La mémoire occupée dépend de la largeur des
+ * images, de la hauteur des bandes et des éléments, jamais de la hauteur des
+ * images.
+ *
+ * @return faux si un fichier est tronqué.
+ */
+bool t_Execution::passeParBandes(const std::vector<int> &cibles, const std::vector<t_EcrivainPgm *> &ecrivains,
+                                 const int hauteurBande) {
+    const int n = (int) noeuds.size();
+    std::vector<int> haut(n, INT_MAX), bas(n, INT_MIN);
+    std::vector<t_Image *> sortie(n, nullptr);
+    std::vector<t_ImageEmpruntee> bandes;
+    int hauteur = 0;
+
+    for (const int c: cibles) {
+        haut[c] = std::min(haut[c], 0);
+        bas[c] = std::max(bas[c], 0);
+        hauteur = std::max(hauteur, h[c]);
+    }
+    int haloHaut, haloBas;
+    plages(haut, bas, haloHaut, haloBas);
+    // bande de chaque cible calculée : ses seules lignes, les lignes de halo
+    // qu'un autre noeud lit restent dans les tampons de bande()
+    for (const int c: cibles)
+        if (completes[c] == nullptr && lecteurs[c] == nullptr && sortie[c] == nullptr) {
+            bandes.emplace_back(emprunterImage(hauteurBande, w[c]));
+            sortie[c] = bandes.back().get();
+        }
+
+    // fenêtres des fichiers lus ; lues[f] : lignes déjà lues
+    std::vector<int> lues(n, 0);
+    for (int f = 0; f < n; f++)
+        if (lecteurs[f] != nullptr && haut[f] <= bas[f]) {
+            possedees[f].reset(emprunterImage(hauteurBande + bas[f] - haut[f], w[f]));
+            completes[f] = possedees[f].get();
+        }
+
+    for (int y0 = 0; y0 < hauteur; y0 += hauteurBande) {
+        const int y1 = std::min(hauteur, y0 + hauteurBande);
+        for (int f = 0; f < n; f++) {
+            if (lecteurs[f] == nullptr || completes[f] == nullptr)
+                continue;
+            t_Image *fenetre = possedees[f].get();
+            const int premiere = std::min(h[f], std::max(0, y0 + haut[f]));
+            const int fin = std::min(h[f], std::max(0, y1 + bas[f]));
+            // les lignes déjà lues encore utiles remontent en tête de la fenêtre
+            for (int r = premiere; r < lues[f]; r++)
+                memmove(fenetre->ligne(r - premiere), fenetre->ligne(r - origine[f]), w[f]);
+            origine[f] = premiere;
+            for (; lues[f] < fin; lues[f]++) {
+                bool Ok;
+                lireLignePgm(lecteurs[f], fenetre->ligne(lues[f] - premiere), Ok);
+                if (!Ok)
+                    return false;
+            }
+        }
+        for (const int c: cibles)
+            if (sortie[c] != nullptr)
+                origine[c] = y0;
+
+        pourBandes(y1 - y0, haloHaut, haloBas, [&](const t_Bande &b) {
+            t_Bande decalee = b;
+            decalee.y0 += y0;
+            decalee.y1 += y0;
+            bande(decalee, haut, bas, sortie);
+        });
+
+        for (size_t k = 0; k < cibles.size(); k++) {
+            const int c = cibles[k];
+            for (int y = y0; y < std::min(y1, h[c]); y++)
+                ecrireLignePgm(ecrivains[k], completes[c] != nullptr ? completes[c]->ligne(y - origine[c])
+                                                                      : sortie[c]->ligne(y - origine[c]));
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Exécute le pipeline : calcule en une passe tous les noeuds demandés
+ *        par sauver() et les enregistre.
+ *
+ * @return faux si une image n'a pas pu être chargée (rien n'est alors calculé
+ *         ni enregistré).
+ */
+bool t_Pipeline::executer() {
+    t_Execution execution(noeuds);
+    for (const auto &s: sauvegardes)
+        execution.preparer(s.noeud);
+    if (!execution.ok)
+        return false;
+
+    std::vector<int> cibles;
+    std::vector<t_ImageEmpruntee> images;
+    std::vector<t_Image *> sorties;
+    for (const auto &s: sauvegardes) {
+        cibles.push_back(s.noeud);
+        images.emplace_back(emprunterImage(execution.h[s.noeud], execution.w[s.noeud]));
+        sorties.push_back(images.back().get());
+    }
+    execution.passe(cibles, sorties);
+
+    for (size_t k = 0; k < sauvegardes.size(); k++)
+        savePgm(sauvegardes[k].fichier, sorties[k], sauvegardes[k].format);
+    return true;
+}
+
+/**
+ * @brief Exécute le pipeline comme executer(), mais par bandes horizontales de
+ *        @p hauteurBande lignes : les fichiers déclarés par charger() sont lus
+ *        et les sorties écrites au fil des bandes, sans jamais tenir une image
+ *        complète en mémoire. Convient aux images plus grandes que la mémoire.
+ *
+ * Les dilatations et érosions sont alors calculées cellule par cellule (sans
+ * décomposition de leur élément), et les images déclarées par source() sont
+ * lues en mémoire comme d'habitude.
+ *
+ * @param hauteurBande Hauteur des bandes ; 0 choisit 64 lignes par thread, au
+ *                     moins 256.
+ * @return faux si un fichier n'a pas pu être lu ; les fichiers de sortie sont
+ *         alors incomplets.
+ */
+bool t_Pipeline::executerParBandes(int hauteurBande) {
+    assert(hauteurBande >= 0);
+    if (hauteurBande == 0)
+        hauteurBande = std::max(256, 64 * nombreThreads());
+    t_Execution execution(noeuds, true);
+    for (const auto &s: sauvegardes)
+        execution.preparer(s.noeud);
+    if (!execution.ok)
+        return false;
+
+    std::vector<int> cibles;
+    std::vector<t_EcrivainPgm *> ecrivains;
+    for (const auto &s: sauvegardes) {
+        cibles.push_back(s.noeud);
+        ecrivains.push_back(creerPgm(s.fichier, execution.h[s.noeud], execution.w[s.noeud], s.format));
+    }
+    const bool Ok = execution.passeParBandes(cibles, ecrivains, hauteurBande);
+    for (t_EcrivainPgm *ecrivain: ecrivains)
+        fermerPgm(ecrivain);
+    return Ok;
+}
+
+/**
+ * @brief Calcule un noeud et renvoie son image, sans rien enregistrer.
+ *
+ * @param Ok faux si une image n'a pas pu être chargée.
+ * @return Image allouée dynamiquement, à libérer avec `delete` (nullptr si !Ok).
+ */
+t_Image *t_Pipeline::calculer(const int noeud, bool &Ok) {
+    assert(noeud >= 0 && noeud < (int) noeuds.size());
+    t_Execution execution(noeuds);
+    execution.preparer(noeud);
+    Ok = execution.ok;
+    if (!Ok)
+        return nullptr;
+
+    auto image = new t_Image(execution.h[noeud], execution.w[noeud]);
+    execution.passe({noeud}, {image});
+    return image;
+}
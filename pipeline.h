@@ -0,0 +1,74 @@
+//
+// Chaînes d'opérateurs déclarées à l'avance puis exécutées ligne à ligne, sans
+// image intermédiaire complète.
+//
+// Exemple : seuillage, ouverture et différence avec l'image seuillée.
+//
+//     t_Pipeline p;
+//     const int seuil = p.seuiller(p.charger("plane.pgm"), 100);
+//     const int ouvert = p.ouvrir(seuil, element3x3);
+//     p.sauver(ouvert, "ouverture.pgm");
+//     p.sauver(p.differencier(seuil, ouvert), "difference.pgm");
+//     p.executer();      // rien n'est calculé avant cet appel
+//
+// executerParBandes() produit les mêmes fichiers en lisant et en écrivant
+// les images par bandes horizontales, pour celles qui ne tiennent pas en
+// mémoire.
+//
+
+#ifndef SMP_TP3_PIPELINE_H
+#define SMP_TP3_PIPELINE_H
+#include <string>
+#include <vector>
+#include "chargesauve.h"
+#include "image.h"
+#include "outils.h"
+
+typedef enum {
+    NOEUD_IMAGE,        // image fournie par l'appelant
+    NOEUD_FICHIER,      // image PGM chargée à l'exécution
+    NOEUD_SEUILLAGE,
+    NOEUD_DILATATION,
+    NOEUD_EROSION,
+    NOEUD_DIFFERENCE
+} t_TypeNoeud;
+
+struct t_Noeud {
+    t_TypeNoeud type;
+    int entrees[2];                    // noeuds lus (-1 si absent)
+    const t_Image *image;              // NOEUD_IMAGE
+    std::string fichier;               // NOEUD_FICHIER
+    unsigned int valeur;               // seuil ou couleur de remplissage
+    std::vector<t_Decalage> decalages; // cellules actives (dilatation, érosion)
+};
+
+struct t_Pipeline {
+    std::vector<t_Noeud> noeuds;
+
+    // déclaration : chaque fonction renvoie l'indice du noeud créé
+    int source(const t_Image *image);
+    int charger(const std::string &nomFichier);
+    int seuiller(int entree, unsigned int s);
+    int dilater(int entree, const t_ElementStructurant *element, unsigned int fillColor = BLACK);
+    int eroder(int entree, const t_ElementStructurant *element, unsigned int fillColor = BLACK);
+    int ouvrir(int entree, const t_ElementStructurant *element, unsigned int fillColor = BLACK);
+    int fermer(int entree, const t_ElementStructurant *element, unsigned int fillColor = BLACK);
+    int differencier(int entree1, int entree2);
+    void sauver(int noeud, const std::string &nomFichier, t_FormatPgm format = PGM_ASCII);
+
+    // exécution
+    bool executer();
+    bool executerParBandes(int hauteurBande = 0);
+    t_Image *calculer(int noeud, bool &Ok);
+
+private:
+    struct t_Sauvegarde {
+        int noeud;
+        std::string fichier;
+        t_FormatPgm format;
+    };
+    std::vector<t_Sauvegarde> sauvegardes;
+
+    int ajouter(const t_Noeud &noeud);
+};
+#endif //SMP_TP3_PIPELINE_H
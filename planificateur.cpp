@@ -0,0 +1,515 @@
+//
+// Décomposition des éléments structurants en unions et compositions d'éléments
+// moins coûteux (segments, rectangles, petits éléments).
+//
+
+#include "planificateur.h"
+#include "noyaux.h"
+#include "parallele.h"
+#include "reserve.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <utility>
+
+/*
+ * Un élément structurant est vu comme l'ensemble S de ses cellules actives. Une
+ * dilatation (resp. érosion) calcule en chaque pixel le minimum (resp. maximum)
+ * E_S des pixels recouverts, puis remplit les pixels où il vaut 0. Deux identités
+ * permettent de réduire le coût de E_S :
+ * - union :       E_{A ∪ B} = op(E_A, E_B) ;
+ * - composition : E_{A ⊕ B} = E_B(E_A), où A ⊕ B = {a + b} est la somme de
+ *                 Minkowski. Le croisement 3x3 est la somme d'un segment
+ *                 horizontal et d'un segment vertical, le losange de rayon r la
+ *                 somme de r croix, l'octogone alterne croix et carrés...
+ * La composition n'est exacte au bord que si le résultat intermédiaire est
+ * calculé au-delà de l'image : les plans comportant une union ou une composition
+ * sont donc exécutés sur une copie de l'image bordée de l'élément neutre.
+ */
+
+// surcoût d'une étape combinant des résultats intermédiaires (mesuré)
+static const int COUT_ETAPE = 4;
+// surcoût de la copie bordée et du recadrage final (mesuré)
+static const int COUT_BORDURE = 16;
+// au-delà, la recherche de décompositions n'est pas tentée
+static const int TAILLE_MAX_RECHERCHE = 64;
+// nombre maximal de formes intermédiaires explorées par planifier()
+static const int FORMES_MAX = 256;
+
+typedef std::vector<std::pair<int, int> > t_Ensemble; // (dy, dx) triés
+
+static t_Ensemble versEnsemble(const std::vector<t_Decalage> &decalages) {
+    t_Ensemble e;
+    for (const auto &d: decalages)
+        e.emplace_back(d.dy, d.dx);
+    std::sort(e.begin(), e.end());
+    e.erase(std::unique(e.begin(), e.end()), e.end());
+    return e;
+}
+
+static std::vector<t_Decalage> versDecalages(const t_Ensemble &e) {
+    std::vector<t_Decalage> decalages;
+    for (const auto &c: e)
+        decalages.push_back({c.second, c.first});
+    return decalages;
+}
+
+static t_Fenetre boite(const t_Ensemble &e) {
+    t_Fenetre f = {e[0].second, e[0].second, e[0].first, e[0].first};
+    for (const auto &c: e) {
+        f.dxMin = std::min(f.dxMin, c.second);
+        f.dxMax = std::max(f.dxMax, c.second);
+        f.dyMin = std::min(f.dyMin, c.first);
+        f.dyMax = std::max(f.dyMax, c.first);
+    }
+    return f;
+}
+
+// appartenance à un ensemble par une grille couvrant sa boîte englobante
+struct t_Grille {
+    t_Fenetre f;
+    int largeur;
+    std::vector<char> cases;
+
+    explicit t_Grille(const t_Ensemble &e) : f(boite(e)), largeur(f.dxMax - f.dxMin + 1),
+                                             cases((size_t) largeur * (f.dyMax - f.dyMin + 1), 0) {
+        for (const auto &c: e)
+            cases[(size_t) (c.first - f.dyMin) * largeur + (c.second - f.dxMin)] = 1;
+    }
+
+    bool contient(const int dy, const int dx) const {
+        return dx >= f.dxMin && dx <= f.dxMax && dy >= f.dyMin && dy <= f.dyMax &&
+               cases[(size_t) (dy - f.dyMin) * largeur + (dx - f.dxMin)];
+    }
+};
+
+static t_Plan planDirect(const t_Ensemble &e) {
+    t_Plan plan;
+    plan.type = ETAPE_DIRECTE;
+    plan.decalages = versDecalages(e);
+    plan.fenetre = {0, 0, 0, 0};
+    plan.cout = (int) e.size();
+    return plan;
+}
+
+static t_Plan planRectangle(const t_Fenetre &f) {
+    t_Plan plan;
+    plan.type = ETAPE_RECTANGLE;
+    plan.fenetre = f;
+    plan.cout = coutRectangle(f);
+    return plan;
+}
+
+// petits éléments centrés dont on cherche à factoriser l'élément
+static const std::vector<t_Ensemble> &facteurs() {
+    static const std::vector<t_Ensemble> liste = {
+        {{0, -1}, {0, 0}, {0, 1}},                                          // segment horizontal 3
+        {{-1, 0}, {0, 0}, {1, 0}},                                          // segment vertical 3
+        {{0, 0}, {0, 1}},                                                   // segment horizontal 2
+        {{0, 0}, {1, 0}},                                                   // segment vertical 2
+        {{-1, -1}, {0, 0}, {1, 1}},                                         // diagonale
+        {{-1, 1}, {0, 0}, {1, -1}},                                         // anti-diagonale
+        {{-1, 0}, {0, -1}, {0, 0}, {0, 1}, {1, 0}},                         // croix 3x3
+        {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 0}, {0, 1}, {1, -1}, {1, 0}, {1, 1}}, // carré 3x3
+    };
+    return liste;
+}
+
+/**
+ * @brief Cherche C tel que C ⊕ B = A. C est l'érodé de A par B : l'ensemble des
+ *        c dont le translaté c + B est inclus dans A.
+ */
+static bool factoriser(const t_Ensemble &a, const t_Grille &grilleA, const t_Ensemble &b, t_Ensemble &c) {
+    c.clear();
+    for (const auto &candidat: a) {
+        bool inclus = true;
+        for (const auto &x: b)
+            if (!grilleA.contient(candidat.first + x.first, candidat.second + x.second)) {
+                inclus = false;
+                break;
+            }
+        if (inclus)
+            c.push_back(candidat);
+    }
+    if (c.empty() || c.size() >= a.size())
+        return false;
+
+    t_Ensemble somme;
+    for (const auto &x: c)
+        for (const auto &y: b)
+            somme.emplace_back(x.first + y.first, x.second + y.second);
+    std::sort(somme.begin(), somme.end());
+    somme.erase(std::unique(somme.begin(), somme.end()), somme.end());
+    return somme == a;
+}
+
+/**
+ * @brief Union de rectangles traités par van Herk et d'un reste de cellules
+ *        isolées. Les rectangles sont choisis un à un, tant qu'il en existe un
+ *        dont le coût est inférieur au nombre de cellules qu'il couvre en plus.
+ */
+static bool planUnion(const t_Ensemble &e, const t_Grille &grille, t_Plan &plan) {
+    // seuls les rectangles assez grands pour payer leur coût sont candidats
+    std::vector<t_Fenetre> rectangles;
+    for (const auto &c: e) {
+        const int y0 = c.first, x0 = c.second;
+        for (int x1 = x0; grille.contient(y0, x1); x1++) {
+            int y1 = y0;
+            while (true) {
+                bool ligneComplete = true;
+                for (int x = x0; x <= x1 && ligneComplete; x++)
+                    ligneComplete = grille.contient(y1 + 1, x);
+                if (!ligneComplete)
+                    break;
+                y1++;
+            }
+            const t_Fenetre r = {x0, x1, y0, y1};
+            if ((x1 - x0 + 1) * (y1 - y0 + 1) > coutRectangle(r) + COUT_ETAPE)
+                rectangles.push_back(r);
+        }
+    }
+    if (rectangles.empty())
+        return false;
+
+    // sommes cumulées des cellules non encore couvertes, pour compter en O(1)
+    // les cellules qu'apporterait chaque rectangle
+    const t_Fenetre &f = grille.f;
+    const int largeur = grille.largeur, hauteur = f.dyMax - f.dyMin + 1;
+    t_Grille couvert = grille;
+    std::fill(couvert.cases.begin(), couvert.cases.end(), 0);
+    std::vector<int> cumul((size_t) (largeur + 1) * (hauteur + 1), 0);
+    auto recalculer = [&]() {
+        for (int y = 0; y < hauteur; y++)
+            for (int x = 0; x < largeur; x++) {
+                const size_t k = (size_t) y * largeur + x;
+                cumul[(size_t) (y + 1) * (largeur + 1) + x + 1] =
+                        (grille.cases[k] && !couvert.cases[k]) + cumul[(size_t) y * (largeur + 1) + x + 1] +
+                        cumul[(size_t) (y + 1) * (largeur + 1) + x] - cumul[(size_t) y * (largeur + 1) + x];
+            }
+    };
+    auto nouvelles = [&](const t_Fenetre &r) {
+        const int x0 = r.dxMin - f.dxMin, x1 = r.dxMax - f.dxMin + 1;
+        const int y0 = r.dyMin - f.dyMin, y1 = r.dyMax - f.dyMin + 1;
+        return cumul[(size_t) y1 * (largeur + 1) + x1] - cumul[(size_t) y0 * (largeur + 1) + x1] -
+               cumul[(size_t) y1 * (largeur + 1) + x0] + cumul[(size_t) y0 * (largeur + 1) + x0];
+    };
+
+    t_Plan u;
+    u.type = ETAPE_UNION;
+    u.cout = 0;
+    while (true) {
+        recalculer();
+        int meilleurGain = 0;
+        const t_Fenetre *meilleur = nullptr;
+        for (const auto &r: rectangles) {
+            const int gain = nouvelles(r) - coutRectangle(r) - COUT_ETAPE;
+            if (gain > meilleurGain) {
+                meilleurGain = gain;
+                meilleur = &r;
+            }
+        }
+        if (meilleur == nullptr)
+            break;
+        for (int y = meilleur->dyMin; y <= meilleur->dyMax; y++)
+            for (int x = meilleur->dxMin; x <= meilleur->dxMax; x++)
+                couvert.cases[(size_t) (y - f.dyMin) * largeur + (x - f.dxMin)] = 1;
+        u.etapes.push_back(planRectangle(*meilleur));
+        u.cout += u.etapes.back().cout + COUT_ETAPE;
+    }
+    if (u.etapes.empty())
+        return false;
+
+    t_Ensemble reste;
+    for (const auto &c: e)
+        if (!couvert.contient(c.first, c.second))
+            reste.push_back(c);
+    if (!reste.empty()) {
+        u.etapes.push_back(planDirect(reste));
+        u.cout += u.etapes.back().cout + COUT_ETAPE;
+    }
+    if (u.etapes.size() == 1)
+        u = u.etapes[0];
+    plan = u;
+    return true;
+}
+
+/**
+ * @brief Translate un plan : le résultat devient celui de l'élément translaté de
+ *        (dx, dy). Pour une composition, il suffit de translater la première étape.
+ */
+static void translater(t_Plan &plan, const int dx, const int dy) {
+    switch (plan.type) {
+        case ETAPE_DIRECTE:
+            for (auto &d: plan.decalages) {
+                d.dx += dx;
+                d.dy += dy;
+            }
+            break;
+        case ETAPE_RECTANGLE:
+            plan.fenetre = {plan.fenetre.dxMin + dx, plan.fenetre.dxMax + dx,
+                            plan.fenetre.dyMin + dy, plan.fenetre.dyMax + dy};
+            break;
+        case ETAPE_UNION:
+            for (auto &etape: plan.etapes)
+                translater(etape, dx, dy);
+            break;
+        case ETAPE_COMPOSITION:
+            translater(plan.etapes[0], dx, dy);
+            break;
+    }
+}
+
+static t_Plan meilleurPlan(const t_Ensemble &e, std::map<t_Ensemble, t_Plan> &memo);
+
+/**
+ * @brief Meilleur plan de @p e, mémorisé à translation près : les factorisations
+ *        successives produisent souvent la même forme en plusieurs positions.
+ */
+static t_Plan planMemorise(const t_Ensemble &e, std::map<t_Ensemble, t_Plan> &memo) {
+    const t_Fenetre b = boite(e);
+    t_Ensemble normalise;
+    for (const auto &c: e)
+        normalise.emplace_back(c.first - b.dyMin, c.second - b.dxMin);
+
+    auto trouve = memo.find(normalise);
+    if (trouve == memo.end())
+        trouve = memo.emplace(normalise, meilleurPlan(normalise, memo)).first;
+    t_Plan plan = trouve->second;
+    translater(plan, b.dxMin, b.dyMin);
+    return plan;
+}
+
+static t_Plan meilleurPlan(const t_Ensemble &e, std::map<t_Ensemble, t_Plan> &memo) {
+    t_Plan meilleur = planDirect(e);
+    const std::vector<t_Decalage> decalages = versDecalages(e);
+    t_Fenetre f;
+    const t_Fenetre b = boite(e);
+
+    if (estRectangle(decalages, &f)) {
+        if (coutRectangle(f) < meilleur.cout)
+            meilleur = planRectangle(f);
+        return meilleur;
+    }
+    if (e.size() <= 9 || b.dxMax - b.dxMin >= TAILLE_MAX_RECHERCHE || b.dyMax - b.dyMin >= TAILLE_MAX_RECHERCHE)
+        return meilleur;
+
+    const t_Grille grille(e);
+    t_Plan candidat;
+    if (planUnion(e, grille, candidat) && candidat.cout < meilleur.cout)
+        meilleur = candidat;
+    if ((int) memo.size() >= FORMES_MAX)
+        return meilleur;
+
+    t_Ensemble reste;
+    for (const auto &facteur: facteurs()) {
+        if (!factoriser(e, grille, facteur, reste))
+            continue;
+        const t_Plan avant = planMemorise(reste, memo);
+        const t_Plan apres = planDirect(facteur);
+        const int cout = avant.cout + apres.cout + COUT_ETAPE;
+        if (cout >= meilleur.cout)
+            continue;
+        t_Plan composition;
+        composition.type = ETAPE_COMPOSITION;
+        composition.cout = cout;
+        if (avant.type == ETAPE_COMPOSITION)
+            composition.etapes = avant.etapes;
+        else
+            composition.etapes.push_back(avant);
+        composition.etapes.push_back(apres);
+        meilleur = composition;
+    }
+    return meilleur;
+}
+
+/**
+ * @brief Choisit la façon la moins coûteuse d'éroder ou de dilater par un élément.
+ *
+ * Les candidats sont : les cellules une à une, un rectangle plein (van Herk),
+ * une union de rectangles et de cellules isolées, et les compositions obtenues
+ * en factorisant l'élément par de petits éléments (segments de 2 ou 3 cellules,
+ * diagonales, croix et carré 3x3), récursivement.
+ *
+ * @param decalages Cellules actives de l'élément structurant.
+ * @return Plan d'exécution et son coût estimé (champ @c cout).
+ */
+t_Plan planifier(const std::vector<t_Decalage> &decalages) {
+    if (decalages.empty())
+        return planDirect({});
+
+    const t_Ensemble e = versEnsemble(decalages);
+    std::map<t_Ensemble, t_Plan> memo;
+    t_Plan plan = planMemorise(e, memo);
+    if (plan.type == ETAPE_UNION || plan.type == ETAPE_COMPOSITION) {
+        // la bordure n'est payée qu'une fois : elle ne départage que le plan final
+        plan.cout += COUT_BORDURE;
+        if (plan.cout >= (int) e.size())
+            plan = planDirect(e);
+    }
+    return plan;
+}
+
+static std::string decrireEtape(const t_Plan &plan) {
+    switch (plan.type) {
+        case ETAPE_DIRECTE:
+            return "directe(" + std::to_string(plan.decalages.size()) + " cellules)";
+        case ETAPE_RECTANGLE:
+            return "rectangle(" + std::to_string(plan.fenetre.dxMax - plan.fenetre.dxMin + 1) + "x" +
+                   std::to_string(plan.fenetre.dyMax - plan.fenetre.dyMin + 1) + ")";
+        default: {
+            std::string texte = plan.type == ETAPE_UNION ? "union(" : "composition(";
+            for (size_t i = 0; i < plan.etapes.size(); i++)
+                texte += (i > 0 ? ", " : "") + decrireEtape(plan.etapes[i]);
+            return texte + ")";
+        }
+    }
+}
+
+/**
+ * @brief Décrit un plan et son coût estimé, par exemple
+ *        « composition(directe(5 cellules), directe(5 cellules)) ; coût estimé 13 ».
+ */
+std::string decrirePlan(const t_Plan &plan) {
+    return decrireEtape(plan) + " ; coût estimé " + std::to_string(plan.cout);
+}
+
+// marges (gauche, droite, haut, bas) à ajouter autour de l'image pour qu'un plan soit exact
+typedef struct {
+    int gauche, droite, haut, bas;
+} t_Marges;
+
+static t_Marges marges(const t_Plan &plan) {
+    t_Marges m = {0, 0, 0, 0};
+    if (plan.type == ETAPE_DIRECTE) {
+        for (const auto &d: plan.decalages) {
+            m.gauche = std::max(m.gauche, -d.dx);
+            m.droite = std::max(m.droite, d.dx);
+            m.haut = std::max(m.haut, -d.dy);
+            m.bas = std::max(m.bas, d.dy);
+        }
+    } else if (plan.type == ETAPE_RECTANGLE) {
+        m = {std::max(0, -plan.fenetre.dxMin), std::max(0, plan.fenetre.dxMax),
+             std::max(0, -plan.fenetre.dyMin), std::max(0, plan.fenetre.dyMax)};
+    } else {
+        for (const auto &etape: plan.etapes) {
+            const t_Marges e = marges(etape);
+            if (plan.type == ETAPE_UNION)
+                m = {std::max(m.gauche, e.gauche), std::max(m.droite, e.droite),
+                     std::max(m.haut, e.haut), std::max(m.bas, e.bas)};
+            else
+                m = {m.gauche + e.gauche, m.droite + e.droite, m.haut + e.haut, m.bas + e.bas};
+        }
+    }
+    return m;
+}
+
+/**
+ * @brief Minimum ou maximum de @p imgIn sous l'élément décrit par @p plan.
+ *
+ * @param imgIn      Image d'entrée ; les pixels hors de l'image sont ignorés à
+ *                   chaque étape (voir executerPlan pour un résultat exact au bord).
+ * @param extremum   Reçoit le résultat ; réallouée aux dimensions de @p imgIn.
+ * @param plan       Plan produit par planifier().
+ * @param estMaximum vrai pour le maximum, faux pour le minimum.
+ *
+ * @pre imgIn != extremum
+ */
+void extremumPlan(const t_Image *imgIn, t_Image *extremum, const t_Plan &plan, const bool estMaximum) {
+    const auto combiner = estMaximum ? noyaux().maxLigne : noyaux().minLigne;
+
+    switch (plan.type) {
+        case ETAPE_DIRECTE:
+            extremum->allouer(imgIn->h, imgIn->w);
+            extremumLignes(imgIn, extremum, plan.decalages, estMaximum, 0, imgIn->h);
+            break;
+        case ETAPE_RECTANGLE:
+            extremumRectangle(imgIn, extremum, plan.fenetre, estMaximum);
+            break;
+        case ETAPE_UNION: {
+            extremumPlan(imgIn, extremum, plan.etapes[0], estMaximum);
+            t_ImageEmpruntee partiel(emprunterImage(imgIn->h, imgIn->w));
+            for (size_t i = 1; i < plan.etapes.size(); i++) {
+                extremumPlan(imgIn, partiel.get(), plan.etapes[i], estMaximum);
+                for (int y = 0; y < imgIn->h; y++)
+                    combiner(extremum->ligne(y), partiel->ligne(y), imgIn->w);
+            }
+            break;
+        }
+        case ETAPE_COMPOSITION: {
+            t_ImageEmpruntee intermediaires[2] = {t_ImageEmpruntee(emprunterImage(imgIn->h, imgIn->w)),
+                                                  t_ImageEmpruntee(emprunterImage(imgIn->h, imgIn->w))};
+            const t_Image *courante = imgIn;
+            for (size_t i = 0; i < plan.etapes.size(); i++) {
+                t_Image *suivante = i + 1 == plan.etapes.size() ? extremum : intermediaires[i % 2].get();
+                extremumPlan(courante, suivante, plan.etapes[i], estMaximum);
+                courante = suivante;
+            }
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Exécute un plan sur les lignes [b.y0, b.y1) de l'image, à partir d'une
+ *        copie de ces lignes et de leur halo bordée de l'élément neutre.
+ */
+static void executerBande(const t_Image *imgIn, t_Image *imgOut, const t_Plan &plan, const t_Marges &m,
+                          const t_Bande &b, const bool estErosion, const unsigned int fillColor) {
+    const t_Pixel neutre = estErosion ? 0 : 255;
+    t_ImageEmpruntee borde(emprunterImage(b.y1 - b.y0 + m.haut + m.bas, imgIn->w + m.gauche + m.droite));
+    for (int y = 0; y < borde->h; y++) {
+        t_Pixel *ligne = borde->ligne(y);
+        const int ySource = b.y0 + y - m.haut;
+        if (ySource < 0 || ySource >= imgIn->h) {
+            memset(ligne, neutre, borde->w);
+            continue;
+        }
+        memset(ligne, neutre, m.gauche);
+        memcpy(ligne + m.gauche, imgIn->ligne(ySource), imgIn->w);
+        memset(ligne + m.gauche + imgIn->w, neutre, m.droite);
+    }
+
+    t_ImageEmpruntee extremum(emprunterImage(borde->h, borde->w));
+    extremumPlan(borde.get(), extremum.get(), plan, estErosion);
+    for (int y = b.y0; y < b.y1; y++)
+        noyaux().remplirSiNul(imgOut->ligne(y), extremum->ligne(y - b.y0 + m.haut) + m.gauche, imgIn->w,
+                              (t_Pixel) fillColor);
+}
+
+/**
+ * @brief Érosion ou dilatation de @p imgIn selon un plan.
+ *
+ * Même résultat que dilatation() ou erosion() avec l'élément planifié. L'image
+ * est découpée en bandes de lignes traitées en parallèle (voir parallele.h).
+ * Une étape directe lit chaque bande et son halo dans l'image même. Un plan à
+ * une seule étape rectangle est exécuté directement sur l'image lorsqu'il n'y a
+ * qu'une bande. Les autres plans sont exécutés bande par bande sur une copie
+ * bordée de l'élément neutre, assez large pour que chaque résultat
+ * intermédiaire soit exact, puis recadrés.
+ *
+ * @param imgIn      Image d'entrée (non modifiée).
+ * @param imgOut     Image de sortie de mêmes dimensions ; seuls les pixels retenus
+ *                   reçoivent @p fillColor.
+ * @param plan       Plan produit par planifier().
+ * @param estErosion vrai pour une érosion, faux pour une dilatation.
+ * @param fillColor  Couleur des pixels retenus (0 à 255).
+ */
+void executerPlan(const t_Image *imgIn, t_Image *imgOut, const t_Plan &plan, const bool estErosion,
+                  const unsigned int fillColor) {
+    const t_Marges m = marges(plan);
+    const std::vector<t_Bande> bandes = decouperBandes(imgIn->h, m.haut, m.bas);
+
+    if (plan.type == ETAPE_DIRECTE) {
+        executerTaches((int) bandes.size(), [&](const int i) {
+            morphologieLignes(imgIn, imgOut, plan.decalages, estErosion, fillColor, bandes[i].y0, bandes[i].y1);
+        });
+        return;
+    }
+    if (plan.type == ETAPE_RECTANGLE && bandes.size() == 1) {
+        morphologieRectangle(imgIn, imgOut, plan.fenetre, estErosion, fillColor);
+        return;
+    }
+    executerTaches((int) bandes.size(), [&](const int i) {
+        executerBande(imgIn, imgOut, plan, m, bandes[i], estErosion, fillColor);
+    });
+}
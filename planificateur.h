@@ -0,0 +1,34 @@
+//
+// Décomposition des éléments structurants en unions et compositions d'éléments
+// moins coûteux (segments, rectangles, petits éléments).
+//
+
+#ifndef SMP_TP3_PLANIFICATEUR_H
+#define SMP_TP3_PLANIFICATEUR_H
+#include <string>
+#include <vector>
+#include "image.h"
+#include "outils.h"
+#include "vanherk.h"
+
+typedef enum {
+    ETAPE_DIRECTE,     // cellules combinées une à une (noyaux.h)
+    ETAPE_RECTANGLE,   // rectangle ou segment plein (vanherk.h)
+    ETAPE_UNION,       // extremum des résultats des sous-plans
+    ETAPE_COMPOSITION  // sous-plans appliqués l'un après l'autre (somme de Minkowski)
+} t_TypeEtape;
+
+struct t_Plan {
+    t_TypeEtape type;
+    std::vector<t_Decalage> decalages; // ETAPE_DIRECTE
+    t_Fenetre fenetre;                 // ETAPE_RECTANGLE
+    std::vector<t_Plan> etapes;        // ETAPE_UNION et ETAPE_COMPOSITION
+    int cout;                          // coût estimé, en passages directs (voir coutRectangle)
+};
+
+t_Plan planifier(const std::vector<t_Decalage> &decalages);
+std::string decrirePlan(const t_Plan &plan);
+void extremumPlan(const t_Image *imgIn, t_Image *extremum, const t_Plan &plan, bool estMaximum);
+void executerPlan(const t_Image *imgIn, t_Image *imgOut, const t_Plan &plan, bool estErosion,
+                  unsigned int fillColor);
+#endif //SMP_TP3_PLANIFICATEUR_H
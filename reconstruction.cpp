@@ -0,0 +1,324 @@
+//
+// Reconstruction géodésique d'une image par un marqueur sous un masque, et ses
+// applications : remplissage des trous, suppression des objets qui touchent le
+// bord.
+//
+
+#include "outils.h"
+#include "instrumentation.h"
+#include "noyaux.h"
+#include "parallele.h"
+#include <algorithm>
+#include <cassert>
+
+/*
+ * Reconstruction hybride de Vincent (1993). Le marqueur grandit dans le masque
+ * sans jamais le dépasser, jusqu'à ce que plus rien ne change ; au lieu de
+ * répéter des dilatations de toute l'image, on fait :
+ *
+ *   1. un balayage dans l'ordre des lignes, où chaque pixel prend la valeur de
+ *      ses voisins déjà traités (au-dessus et à gauche), bornée par le masque ;
+ *   2. un balayage en sens inverse (au-dessous et à droite), qui range dans une
+ *      file d'attente les pixels dont un voisin déjà traité peut encore grandir ;
+ *   3. la propagation de la file : chaque pixel sorti pousse sa valeur vers ses
+ *      voisins, qui y entrent à leur tour s'ils ont changé.
+ *
+ * Les deux balayages suffisent pour la plupart des formes ; la file ne traite
+ * que les chemins qui reviennent en arrière (spirales, formes en U).
+ *
+ * Vincent utilise une seule file, dans l'ordre d'arrivée. En niveaux de gris,
+ * un pixel y revient alors chaque fois qu'une valeur plus haute l'atteint, et
+ * tout ce qu'il avait propagé est à refaire. Ici, la file est rangée par niveau
+ * (une pile par valeur) et vidée du plus haut au plus bas : un pixel sorti a sa
+ * valeur définitive et n'est propagé qu'une fois. Tous les pixels d'une même
+ * pile reçoivent la même valeur, leur ordre est donc libre ; une pile propage
+ * de proche en proche, là où une file en largeur saute d'un bout à l'autre de
+ * l'image et sort du cache à chaque pixel.
+ *
+ * Dans un balayage, la ligne voisine déjà traitée est combinée à toute la ligne
+ * d'un coup par les noyaux vectoriels ; seul le voisin de gauche (ou de droite)
+ * impose une boucle pixel par pixel. Les trois étapes dépendent de leur ordre :
+ * la reconstruction n'est pas découpée en bandes.
+ *
+ * Le calcul se fait sur des plans d'un octet par pixel bordés d'une ligne et
+ * d'une colonne de zéros, où les valeurs grandissent vers 255 : le bord est à la
+ * fois dans le marqueur et dans le masque, il n'est donc jamais modifié et les
+ * voisinages se lisent sans test. Les opérations où l'objet noir grandit
+ * (dilatation au sens de dilatation()) y recopient les niveaux inversés.
+ */
+
+// plan bordé de (w + 2) x (h + 2) octets, initialisé à 0
+static std::vector<t_Pixel> planBorde(const int w, const int h) {
+    return std::vector<t_Pixel>((size_t) (w + 2) * (h + 2), 0);
+}
+
+/**
+ * @brief Recopie une image dans l'intérieur d'un plan bordé.
+ *
+ * @param inverse 0xFF pour recopier les niveaux inversés (255 - v), 0 sinon.
+ */
+static void recopier(const t_Image *image, std::vector<t_Pixel> &plan, const t_Pixel inverse) {
+    const int w = image->w, pas = w + 2;
+    pourBandes(image->h, 0, 0, [&](const t_Bande &b) {
+        for (int y = b.y0; y < b.y1; y++) {
+            const t_Pixel *ligne = image->ligne(y);
+            t_Pixel *p = plan.data() + (size_t) (y + 1) * pas + 1;
+            for (int x = 0; x < w; x++)
+                p[x] = ligne[x] ^ inverse;
+        }
+    });
+}
+
+/**
+ * @brief Reconstruit le marqueur J sous le masque I, deux plans bordés de même
+ *        taille où J <= I.
+ *
+ * À la fin, J est le plus grand plan sous I dont chaque pixel est relié à un
+ * pixel du marqueur initial au moins aussi haut par un chemin où il ne descend
+ * pas plus bas que lui.
+ */
+static void propager(std::vector<t_Pixel> &J, const std::vector<t_Pixel> &I, const int w, const int h,
+                     const t_Connexite connexite) {
+    const t_Noyaux &k = noyaux();
+    const int pas = w + 2;
+    const bool coins = connexite == CONNEXITE_8;
+
+    // 1. balayage direct : J = min(max(J, voisins du haut, voisin de gauche), I).
+    // Borner par I avant d'ajouter le voisin de gauche ne change pas le résultat.
+    for (int y = 1; y <= h; y++) {
+        t_Pixel *j = J.data() + (size_t) y * pas + 1;
+        const t_Pixel *i = I.data() + (size_t) y * pas + 1;
+        const t_Pixel *haut = j - pas;
+        k.maxLigne(j, haut, w);
+        if (coins) {
+            k.maxLigne(j, haut - 1, w);
+            k.maxLigne(j, haut + 1, w);
+        }
+        k.minLigne(j, i, w);
+        t_Pixel gauche = 0;
+        for (int x = 0; x < w; x++)
+            j[x] = gauche = std::min(std::max(j[x], gauche), i[x]);
+    }
+
+    // 2. balayage inverse, qui remplit la pile du niveau de chaque pixel
+    std::vector<std::vector<size_t> > piles(256);
+    std::vector<uint64_t> bits((w + 63) / 64);
+    for (int y = h; y >= 1; y--) {
+        t_Pixel *j = J.data() + (size_t) y * pas + 1;
+        const t_Pixel *i = I.data() + (size_t) y * pas + 1;
+        k.maxLigne(j, j + pas, w);
+        if (coins) {
+            k.maxLigne(j, j + pas - 1, w);
+            k.maxLigne(j, j + pas + 1, w);
+        }
+        k.minLigne(j, i, w);
+        t_Pixel droite = 0;
+        for (int x = w - 1; x >= 0; x--)
+            j[x] = droite = std::min(std::max(j[x], droite), i[x]);
+        // pixels dont un voisin déjà traité, plus bas qu'eux et que son masque,
+        // peut encore grandir : marqués sur toute la ligne, puis relevés mot par mot
+        std::fill(bits.begin(), bits.end(), 0);
+        k.marquerInferieurs(bits.data(), j + 1, j, i + 1, w);
+        k.marquerInferieurs(bits.data(), j + pas, j, i + pas, w);
+        if (coins) {
+            k.marquerInferieurs(bits.data(), j + pas - 1, j, i + pas - 1, w);
+            k.marquerInferieurs(bits.data(), j + pas + 1, j, i + pas + 1, w);
+        }
+        for (size_t m = 0; m < bits.size(); m++)
+            for (uint64_t mot = bits[m]; mot != 0; mot &= mot - 1) {
+                const int x = (int) m * 64 + __builtin_ctzll(mot);
+                piles[j[x]].push_back((size_t) y * pas + 1 + x);
+            }
+    }
+
+    // 3. propagation, du niveau le plus haut au plus bas : un pixel reçoit des
+    // valeurs au plus égales au niveau en cours, et passe dans la pile de sa
+    // nouvelle valeur (la même ou une plus basse, traitée plus tard)
+    const ptrdiff_t voisins[8] = {-pas, -1, 1, pas, -pas - 1, -pas + 1, pas - 1, pas + 1};
+    const int nombreVoisins = coins ? 8 : 4;
+    for (int niveau = 255; niveau >= 0; niveau--) {
+        std::vector<size_t> &pile = piles[niveau];
+        while (!pile.empty()) {
+            const size_t p = pile.back();
+            pile.pop_back();
+            // pixel remonté depuis son entrée : déjà propagé depuis une pile plus haute
+            if (J[p] != niveau)
+                continue;
+            for (int n = 0; n < nombreVoisins; n++) {
+                // J <= I partout : J[q] < I[q] quand q peut encore grandir
+                const size_t q = p + voisins[n];
+                const t_Pixel cible = std::min((t_Pixel) niveau, I[q]);
+                if (J[q] < cible) {
+                    J[q] = cible;
+                    piles[cible].push_back(q);
+                }
+            }
+        }
+        std::vector<size_t>().swap(pile);
+    }
+}
+
+/**
+ * @brief Marqueur bordé égal au masque sur le bord de l'image et nul ailleurs.
+ */
+static std::vector<t_Pixel> marqueurBord(const std::vector<t_Pixel> &I, const int w, const int h) {
+    const int pas = w + 2;
+    std::vector<t_Pixel> J = planBorde(w, h);
+    for (const int y: {1, h}) {
+        const size_t debut = (size_t) y * pas + 1;
+        std::copy(I.begin() + (ptrdiff_t) debut, I.begin() + (ptrdiff_t) (debut + w), J.begin() + (ptrdiff_t) debut);
+    }
+    for (int y = 2; y < h; y++)
+        for (const int x: {1, w}) {
+            const size_t p = (size_t) y * pas + x;
+            J[p] = I[p];
+        }
+    return J;
+}
+
+static void reconstruire(const t_Image *marqueur, const t_Image *masque, t_Image *sortie, const t_Pixel inverse,
+                         const t_Connexite connexite) {
+    assert(marqueur->w == masque->w && "La largeur du marqueur et du masque doivent être égale.");
+    assert(marqueur->h == masque->h && "La hauteur du marqueur et du masque doivent être égale.");
+    assert(sortie->w == masque->w && "La largeur de l'image d'entrée et de sortie doivent être égale.");
+    assert(sortie->h == masque->h && "La hauteur de l'image d'entrée et de sortie doivent être égale.");
+    const int w = masque->w, h = masque->h, pas = w + 2;
+    std::vector<t_Pixel> I = planBorde(w, h), J = planBorde(w, h);
+    recopier(masque, I, inverse);
+    recopier(marqueur, J, inverse);
+    // le marqueur est d'abord ramené sous le masque
+    for (int y = 1; y <= h; y++)
+        noyaux().minLigne(J.data() + (size_t) y * pas + 1, I.data() + (size_t) y * pas + 1, w);
+
+    propager(J, I, w, h, connexite);
+
+    // après les lectures : la sortie peut être le marqueur ou le masque
+    pourBandes(h, 0, 0, [&](const t_Bande &b) {
+        for (int y = b.y0; y < b.y1; y++) {
+            const t_Pixel *j = J.data() + (size_t) (y + 1) * pas + 1;
+            t_Pixel *ligne = sortie->ligne(y);
+            for (int x = 0; x < w; x++)
+                ligne[x] = j[x] ^ inverse;
+        }
+    });
+}
+
+/**
+ * @brief Reconstruction par dilatation : l'objet (noir) du marqueur grandit,
+ *        au sens de dilatation(), sans sortir de l'objet du masque.
+ *
+ * En binaire, la sortie contient les composantes de l'objet du masque qui
+ * touchent l'objet du marqueur. En niveaux de gris, chaque pixel descend au
+ * niveau le plus sombre qui lui parvient du marqueur par un chemin du masque,
+ * sans jamais descendre sous le masque.
+ *
+ * @param marqueur  Marqueur ; un pixel plus sombre que le masque est d'abord
+ *                  ramené au niveau du masque.
+ * @param masque    Masque.
+ * @param sortie    Reçoit la reconstruction ; peut être le marqueur ou le masque.
+ * @param connexite Voisins par lesquels l'objet grandit.
+ *
+ * @pre marqueur, masque et sortie de même taille
+ */
+void reconstructionDilatation(const t_Image *marqueur, const t_Image *masque, t_Image *sortie,
+                              const t_Connexite connexite) {
+    INSTRUMENTER("reconstructionDilatation");
+    COMPTER_PIXELS((size_t) masque->w * masque->h);
+    COMPTER_LECTURE(2 * (size_t) masque->w * masque->h);
+    reconstruire(marqueur, masque, sortie, 0xFF, connexite);
+}
+
+/**
+ * @brief Reconstruction par érosion : le fond (blanc) du marqueur grandit, au
+ *        sens de erosion(), sans sortir du fond du masque.
+ *
+ * C'est l'opération duale de reconstructionDilatation() : chaque pixel monte au
+ * niveau le plus clair qui lui parvient du marqueur, sans dépasser le masque.
+ *
+ * @param marqueur  Marqueur ; un pixel plus clair que le masque est d'abord
+ *                  ramené au niveau du masque.
+ * @param masque    Masque.
+ * @param sortie    Reçoit la reconstruction ; peut être le marqueur ou le masque.
+ * @param connexite Voisins par lesquels le fond grandit.
+ *
+ * @pre marqueur, masque et sortie de même taille
+ */
+void reconstructionErosion(const t_Image *marqueur, const t_Image *masque, t_Image *sortie,
+                           const t_Connexite connexite) {
+    INSTRUMENTER("reconstructionErosion");
+    COMPTER_PIXELS((size_t) masque->w * masque->h);
+    COMPTER_LECTURE(2 * (size_t) masque->w * masque->h);
+    reconstruire(marqueur, masque, sortie, 0, connexite);
+}
+
+/**
+ * @brief Remplit les trous de l'objet : les parties du fond qu'aucun chemin du
+ *        fond ne relie au bord de l'image.
+ *
+ * Le fond est reconstruit depuis le bord (reconstruction par érosion dont le
+ * marqueur est l'image sur son bord et noir ailleurs). En niveaux de gris, les
+ * zones claires entourées de pixels plus sombres descendent au niveau de leur
+ * entourage.
+ *
+ * @param connexite Connexité de l'objet ; le fond suit l'autre (un trou d'un
+ *                  objet en 8-connexité se vide par un côté, pas par un coin).
+ *
+ * @pre imgIn != imgOut, de même taille
+ */
+void remplirTrous(const t_Image *imgIn, t_Image *imgOut, const t_Connexite connexite) {
+    INSTRUMENTER("remplirTrous");
+    assert(imgIn != imgOut && "L'image de sortie doit être distincte de l'image d'entrée.");
+    assert(imgOut->w == imgIn->w && "La largeur de l'image d'entrée et de sortie doivent être égale.");
+    assert(imgOut->h == imgIn->h && "La hauteur de l'image d'entrée et de sortie doivent être égale.");
+    COMPTER_PIXELS((size_t) imgIn->w * imgIn->h);
+    COMPTER_LECTURE((size_t) imgIn->w * imgIn->h);
+    const int w = imgIn->w, h = imgIn->h, pas = w + 2;
+    std::vector<t_Pixel> I = planBorde(w, h);
+    recopier(imgIn, I, 0);
+    std::vector<t_Pixel> J = marqueurBord(I, w, h);
+    propager(J, I, w, h, connexite == CONNEXITE_8 ? CONNEXITE_4 : CONNEXITE_8);
+
+    pourBandes(h, 0, 0, [&](const t_Bande &b) {
+        for (int y = b.y0; y < b.y1; y++)
+            std::copy(J.data() + (size_t) (y + 1) * pas + 1, J.data() + (size_t) (y + 1) * pas + 1 + w,
+                      imgOut->ligne(y));
+    });
+}
+
+/**
+ * @brief Supprime les objets qui touchent le bord de l'image.
+ *
+ * L'objet relié au bord est reconstruit (reconstruction par dilatation dont le
+ * marqueur est l'image sur son bord et blanc ailleurs), puis retiré de l'image :
+ * la sortie vaut WHITE - (reconstruction - image). En binaire, les composantes
+ * de l'objet qui touchent le bord deviennent du fond et les autres restent
+ * intactes.
+ *
+ * @param connexite Connexité de l'objet.
+ *
+ * @pre imgIn != imgOut, de même taille
+ */
+void supprimerBord(const t_Image *imgIn, t_Image *imgOut, const t_Connexite connexite) {
+    INSTRUMENTER("supprimerBord");
+    assert(imgIn != imgOut && "L'image de sortie doit être distincte de l'image d'entrée.");
+    assert(imgOut->w == imgIn->w && "La largeur de l'image d'entrée et de sortie doivent être égale.");
+    assert(imgOut->h == imgIn->h && "La hauteur de l'image d'entrée et de sortie doivent être égale.");
+    COMPTER_PIXELS((size_t) imgIn->w * imgIn->h);
+    COMPTER_LECTURE((size_t) imgIn->w * imgIn->h);
+    const int w = imgIn->w, h = imgIn->h, pas = w + 2;
+    std::vector<t_Pixel> I = planBorde(w, h);
+    recopier(imgIn, I, 0xFF);
+    std::vector<t_Pixel> J = marqueurBord(I, w, h);
+    propager(J, I, w, h, connexite);
+
+    // niveaux inversés : reconstruction - image = I - J
+    pourBandes(h, 0, 0, [&](const t_Bande &b) {
+        for (int y = b.y0; y < b.y1; y++) {
+            const t_Pixel *i = I.data() + (size_t) (y + 1) * pas + 1;
+            const t_Pixel *j = J.data() + (size_t) (y + 1) * pas + 1;
+            t_Pixel *ligne = imgOut->ligne(y);
+            for (int x = 0; x < w; x++)
+                ligne[x] = (t_Pixel) (WHITE - (i[x] - j[x]));
+        }
+    });
+}
@@ -0,0 +1,223 @@
+//
+// Recalcul incrémental des opérateurs sur une région modifiée de l'image.
+//
+
+#include "region.h"
+#include "noyaux.h"
+#include "reserve.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+// étendue des décalages actifs d'un élément : le pixel (x, y) du résultat lit
+// les pixels (x + dx, y + dy) de l'entrée pour dxMin <= dx <= dxMax, etc.
+typedef struct {
+    int dxMin, dxMax, dyMin, dyMax;
+} t_Support;
+
+static t_Support support(const t_ElementStructurant *element) {
+    t_Support s = {0, 0, 0, 0};
+    for (const auto &d: decalagesActifs(element)) {
+        s.dxMin = std::min(s.dxMin, d.dx);
+        s.dxMax = std::max(s.dxMax, d.dx);
+        s.dyMin = std::min(s.dyMin, d.dy);
+        s.dyMax = std::max(s.dyMax, d.dy);
+    }
+    return s;
+}
+
+// support de deux opérateurs enchaînés avec le même élément
+static t_Support enchaine(const t_Support &s) {
+    return {2 * s.dxMin, 2 * s.dxMax, 2 * s.dyMin, 2 * s.dyMax};
+}
+
+static t_Region intersection(const t_Region &a, const t_Region &b) {
+    return {std::max(a.x0, b.x0), std::max(a.y0, b.y0), std::min(a.x1, b.x1), std::min(a.y1, b.y1)};
+}
+
+// pixels de l'entrée lus pour calculer la région r du résultat
+static t_Region lue(const t_Region &r, const t_Support &s) {
+    return {r.x0 + s.dxMin, r.y0 + s.dyMin, r.x1 + s.dxMax, r.y1 + s.dyMax};
+}
+
+// pixels du résultat qui lisent un pixel de la région r de l'entrée
+static t_Region atteinte(const t_Region &r, const t_Support &s) {
+    return {r.x0 - s.dxMax, r.y0 - s.dyMax, r.x1 - s.dxMin, r.y1 - s.dyMin};
+}
+
+/**
+ * @brief Région couvrant toute l'image : pour tout recalculer, ou comme
+ *        région modifiée d'une image entièrement nouvelle.
+ */
+t_Region regionImage(const t_Image *image) {
+    return {0, 0, image->w, image->h};
+}
+
+/**
+ * @brief Plus petit rectangle contenant les deux régions (une région vide est
+ *        ignorée).
+ */
+t_Region reunion(const t_Region &a, const t_Region &b) {
+    if (estVide(a))
+        return b;
+    if (estVide(b))
+        return a;
+    return {std::min(a.x0, b.x0), std::min(a.y0, b.y0), std::max(a.x1, b.x1), std::max(a.y1, b.y1)};
+}
+
+bool estVide(const t_Region &region) {
+    return region.x0 >= region.x1 || region.y0 >= region.y1;
+}
+
+// bloc d'une vue : les pixels appartiennent à une autre image, rien à rendre
+static void rienALiberer(void *, size_t) {
+}
+
+/**
+ * @brief Recalcule la région @p cible de @p imgOut en appliquant @p operation à
+ *        la seule partie de @p imgIn qu'elle lit.
+ *
+ * L'opération reçoit une vue sur la partie lue de l'entrée (la région cible
+ * étendue par @p s, sans copie) et une image blanche de mêmes dimensions ; seule
+ * la région cible du résultat est recopiée dans @p imgOut. Les bords de la vue
+ * qui ne sont pas des bords de l'image n'influencent pas la région cible, car
+ * aucun de ses pixels ne lit au-delà.
+ */
+static void recalculer(const t_Image *imgIn, t_Image *imgOut, const t_Region &cible, const t_Support &s,
+                       const std::function<void(const t_Image *, t_Image *)> &operation) {
+    if (estVide(cible))
+        return;
+    const t_Region l = intersection(lue(cible, s), regionImage(imgIn));
+    t_Image vue;
+    vue.adopter(const_cast<t_Pixel *>(imgIn->ligne(l.y0)) + l.x0, l.y1 - l.y0, l.x1 - l.x0, imgIn->stride,
+                nullptr, 0, rienALiberer);
+    t_ImageEmpruntee resultat(emprunterImage(vue.h, vue.w, WHITE));
+    operation(&vue, resultat.get());
+    for (int y = cible.y0; y < cible.y1; y++)
+        memcpy(imgOut->ligne(y) + cible.x0, resultat->ligne(y - l.y0) + (cible.x0 - l.x0), cible.x1 - cible.x0);
+}
+
+/**
+ * @brief Seuillage limité à une région de l'image.
+ *
+ * @param image    Image modifiée sur place.
+ * @param s        Seuil (0 à 255), comme pour seuillage().
+ * @param modifiee Région de l'image qui a changé depuis le dernier seuillage.
+ * @return La région seuillée (@p modifiee limitée à l'image).
+ */
+t_Region seuillageRegion(t_Image *image, const unsigned int s, const t_Region modifiee) {
+    assert(s <= 255 && "La valeur du seuil doit respecter : 0 <= s <= 255");
+    const t_Region r = intersection(modifiee, regionImage(image));
+    for (int y = r.y0; y < r.y1; y++) {
+        t_Pixel *ligne = image->ligne(y);
+        for (int x = r.x0; x < r.x1; x++)
+            ligne[x] = ligne[x] < s ? 0 : 255;
+    }
+    return r;
+}
+
+/**
+ * @brief Met à jour une dilatation après la modification d'une région de
+ *        l'entrée.
+ *
+ * @param imgIn     Image d'entrée, déjà modifiée.
+ * @param imgOut    Résultat de dilatation(imgIn, imgOut, element, fillColor)
+ *                  calculé avant la modification (image initialement blanche).
+ * @param element   Élément structurant utilisé pour ce résultat.
+ * @param modifiee  Région de @p imgIn qui a changé.
+ * @param fillColor Couleur de remplissage utilisée pour ce résultat.
+ * @return La région de @p imgOut recalculée : @p modifiee étendue par le support
+ *         de l'élément et limitée à l'image.
+ *
+ * @pre imgOut a les dimensions de imgIn
+ *
+ * @note Les pixels de la région recalculée qui ne sont pas remplis valent WHITE.
+ */
+t_Region dilatationRegion(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *element,
+                          const t_Region modifiee, const unsigned int fillColor) {
+    assert(imgOut->w == imgIn->w && imgOut->h == imgIn->h);
+    const t_Support s = support(element);
+    const t_Region cible = intersection(atteinte(modifiee, s), regionImage(imgIn));
+    recalculer(imgIn, imgOut, cible, s, [&](const t_Image *in, t_Image *out) {
+        dilatation(in, out, element, fillColor);
+    });
+    return cible;
+}
+
+/**
+ * @brief Met à jour une érosion après la modification d'une région de
+ *        l'entrée (voir dilatationRegion()).
+ */
+t_Region erosionRegion(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *element,
+                       const t_Region modifiee, const unsigned int fillColor) {
+    assert(imgOut->w == imgIn->w && imgOut->h == imgIn->h);
+    const t_Support s = support(element);
+    const t_Region cible = intersection(atteinte(modifiee, s), regionImage(imgIn));
+    recalculer(imgIn, imgOut, cible, s, [&](const t_Image *in, t_Image *out) {
+        erosion(in, out, element, fillColor);
+    });
+    return cible;
+}
+
+/**
+ * @brief Met à jour une ouverture après la modification d'une région de
+ *        l'entrée (voir dilatationRegion()).
+ *
+ * L'érosion intermédiaire n'est pas conservée : elle est recalculée sur la
+ * région lue par la dilatation, si bien que la région mise à jour est
+ * @p modifiee étendue deux fois par le support de l'élément.
+ */
+t_Region ouvertureRegion(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *element,
+                         const t_Region modifiee, const unsigned int fillColor) {
+    assert(imgOut->w == imgIn->w && imgOut->h == imgIn->h);
+    const t_Support s = enchaine(support(element));
+    const t_Region cible = intersection(atteinte(modifiee, s), regionImage(imgIn));
+    recalculer(imgIn, imgOut, cible, s, [&](const t_Image *in, t_Image *out) {
+        ouverture(in, out, element, fillColor);
+    });
+    return cible;
+}
+
+/**
+ * @brief Met à jour une fermeture après la modification d'une région de
+ *        l'entrée (voir ouvertureRegion()).
+ */
+t_Region fermetureRegion(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *element,
+                         const t_Region modifiee, const unsigned int fillColor) {
+    assert(imgOut->w == imgIn->w && imgOut->h == imgIn->h);
+    const t_Support s = enchaine(support(element));
+    const t_Region cible = intersection(atteinte(modifiee, s), regionImage(imgIn));
+    recalculer(imgIn, imgOut, cible, s, [&](const t_Image *in, t_Image *out) {
+        fermeture(in, out, element, fillColor);
+    });
+    return cible;
+}
+
+/**
+ * @brief Met à jour une différence après la modification d'une région de
+ *        l'une de ses entrées.
+ *
+ * @param sortie   Résultat de difference(img1, img2, sortie) calculé avant la
+ *                 modification.
+ * @param modifiee Réunion des régions modifiées de @p img1 et de @p img2.
+ * @return La région recalculée (@p modifiee limitée à la sortie).
+ *
+ * @pre sortie a les dimensions données par difference() (maximum des deux entrées)
+ */
+t_Region differenceRegion(const t_Image *img1, const t_Image *img2, t_Image *sortie, const t_Region modifiee) {
+    assert(sortie->w == std::max(img1->w, img2->w) && sortie->h == std::max(img1->h, img2->h));
+    const t_Region r = intersection(modifiee, regionImage(sortie));
+    // largeur de la partie de chaque ligne d'entrée comprise dans [x0, x1)
+    auto largeur = [&](const t_Image *image, const int y) {
+        return y < image->h ? std::max(0, std::min(image->w, r.x1) - r.x0) : 0;
+    };
+    for (int y = r.y0; y < r.y1; y++) {
+        const int n1 = largeur(img1, y), n2 = largeur(img2, y);
+        differenceLignes(sortie->ligne(y) + r.x0, r.x1 - r.x0, n1 > 0 ? img1->ligne(y) + r.x0 : nullptr, n1,
+                         n2 > 0 ? img2->ligne(y) + r.x0 : nullptr, n2, 0);
+    }
+    return r;
+}
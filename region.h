@@ -0,0 +1,41 @@
+//
+// Recalcul incrémental : lorsqu'une partie seulement de l'image d'entrée a
+// changé, les opérateurs ne mettent à jour que la partie du résultat qui en
+// dépend, dans un résultat calculé auparavant.
+//
+// Exemple : ouverture puis différence après la modification d'un rectangle.
+//
+//     t_Region r = {x0, y0, x1, y1};                      // pixels modifiés de seuil
+//     const t_Region r1 = ouvertureRegion(seuil, ouvert, element, r);
+//     differenceRegion(seuil, ouvert, diff, reunion(r, r1));
+//
+// Chaque fonction renvoie la région du résultat qui a pu changer, à passer à
+// l'opérateur suivant de la chaîne. Le coût est proportionnel à la taille de
+// la région étendue par le support de l'élément, non à celle de l'image.
+//
+
+#ifndef SMP_TP3_REGION_H
+#define SMP_TP3_REGION_H
+#include "image.h"
+#include "outils.h"
+
+// rectangle de pixels [x0, x1) x [y0, y1)
+typedef struct {
+    int x0, y0, x1, y1;
+} t_Region;
+
+t_Region regionImage(const t_Image *image);
+t_Region reunion(const t_Region &a, const t_Region &b);
+bool estVide(const t_Region &region);
+
+t_Region seuillageRegion(t_Image *image, unsigned int s, t_Region modifiee);
+t_Region dilatationRegion(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *element,
+                          t_Region modifiee, unsigned int fillColor = BLACK);
+t_Region erosionRegion(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *element,
+                       t_Region modifiee, unsigned int fillColor = BLACK);
+t_Region ouvertureRegion(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *element,
+                         t_Region modifiee, unsigned int fillColor = BLACK);
+t_Region fermetureRegion(const t_Image *imgIn, t_Image *imgOut, const t_ElementStructurant *element,
+                         t_Region modifiee, unsigned int fillColor = BLACK);
+t_Region differenceRegion(const t_Image *img1, const t_Image *img2, t_Image *sortie, t_Region modifiee);
+#endif //SMP_TP3_REGION_H
@@ -0,0 +1,130 @@
+//
+// Réserve d'images temporaires, partagée par tous les threads.
+//
+
+#include "reserve.h"
+#include <cassert>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// plus petit bloc conservé, et taille totale au-delà de laquelle les images
+// rendues sont détruites
+static const size_t TAILLE_MIN = 4096;
+static const size_t TAILLE_MAX_RESERVE = (size_t) 512 << 20;
+
+/*
+ * Classes de taille : 2^k, 1,25 x 2^k, 1,5 x 2^k et 1,75 x 2^k octets. Une image
+ * rendue est rangée dans la plus grande classe que son bloc contient, un
+ * emprunt cherche la plus petite classe qui contient sa demande : tout bloc
+ * de la classe convient, et au plus un quart de bloc est perdu.
+ */
+static size_t classe(const size_t taille, const bool superieure) {
+    if (taille <= TAILLE_MIN)
+        return superieure || taille == TAILLE_MIN ? TAILLE_MIN : 0;
+    const int k = 63 - __builtin_clzll(taille);
+    const size_t pas = (size_t) 1 << (k - 2);
+    size_t c = taille / pas * pas;
+    if (superieure && c < taille)
+        c += pas;
+    return c;
+}
+
+// images conservées, rangées par classe ; celles qui restent à la fin du
+// programme sont détruites avec la réserve
+struct t_Reserve {
+    std::mutex verrou;
+    std::map<size_t, std::vector<t_Image *> > classes;
+    size_t tailleConservee = 0;
+
+    ~t_Reserve() {
+        for (auto &paquet: classes)
+            for (t_Image *image: paquet.second)
+                delete image;
+    }
+};
+
+static t_Reserve reserve;
+
+/**
+ * @brief Emprunte une image de dimensions h x w à la réserve.
+ *
+ * Les pixels ne sont pas initialisés : l'appelant doit les écrire tous, ou
+ * utiliser la version qui les remplit. L'image est rendue par rendreImage()
+ * (ou par un t_ImageEmpruntee) ; elle peut aussi être détruite par delete.
+ *
+ * @return Une image conservée par la réserve si l'une convient, sinon une
+ *         nouvelle image.
+ */
+t_Image *emprunterImage(const int h, const int w) {
+    const size_t stride = (size_t) (w + ALIGNEMENT - 1) / ALIGNEMENT * ALIGNEMENT;
+    const size_t c = classe((size_t) h * stride, true);
+    t_Image *image = nullptr;
+    {
+        std::lock_guard<std::mutex> garde(reserve.verrou);
+        auto it = reserve.classes.find(c);
+        if (it != reserve.classes.end() && !it->second.empty()) {
+            image = it->second.back();
+            it->second.pop_back();
+            reserve.tailleConservee -= c;
+        }
+    }
+    if (image == nullptr) {
+        image = new t_Image();
+        image->reserver(c);
+    }
+    image->allouer(h, w);
+    return image;
+}
+
+/**
+ * @brief Emprunte une image dont tous les pixels valent @p backgroundColor.
+ *
+ * @pre 0 <= backgroundColor <= 255
+ */
+t_Image *emprunterImage(const int h, const int w, const unsigned int backgroundColor) {
+    assert(backgroundColor <= 255 && "La valeur de la couleur de remplissage doit respecter : 0 <= s <= 255");
+    t_Image *image = emprunterImage(h, w);
+    for (int i = 0; i < image->h; i++)
+        memset(image->ligne(i), backgroundColor, image->w);
+    return image;
+}
+
+/**
+ * @brief Rend une image à la réserve.
+ *
+ * Toute image allouée sur le tas peut être rendue, empruntée ou non. Une vue
+ * (voir t_Image::adopter), un bloc trop petit ou une réserve pleine entraînent
+ * la destruction de l'image.
+ */
+void rendreImage(t_Image *image) {
+    if (image == nullptr)
+        return;
+    const size_t c = classe(image->capaciteAllouee(), false);
+    {
+        std::lock_guard<std::mutex> garde(reserve.verrou);
+        if (c != 0 && reserve.tailleConservee + c <= TAILLE_MAX_RESERVE) {
+            reserve.classes[c].push_back(image);
+            reserve.tailleConservee += c;
+            return;
+        }
+    }
+    delete image;
+}
+
+/**
+ * @brief Détruit toutes les images conservées par la réserve, par exemple à la
+ *        fin d'une chaîne de traitements ou d'un lot.
+ */
+void viderReserve() {
+    std::map<size_t, std::vector<t_Image *> > liberees;
+    {
+        std::lock_guard<std::mutex> garde(reserve.verrou);
+        liberees.swap(reserve.classes);
+        reserve.tailleConservee = 0;
+    }
+    for (auto &paquet: liberees)
+        for (t_Image *image: paquet.second)
+            delete image;
+}
@@ -0,0 +1,30 @@
+//
+// Réserve d'images temporaires : les blocs de pixels des images rendues sont
+// conservés par classe de taille et réutilisés par les emprunts suivants, ce
+// qui évite une allocation (et les défauts de page d'un bloc neuf) à chaque
+// image intermédiaire.
+//
+// Exemple :
+//
+//     t_ImageEmpruntee tampon(emprunterImage(h, w));      // pixels non initialisés
+//     ...                                                 // rendue à la destruction
+//     viderReserve();                                     // fin du traitement : tout est libéré
+//
+
+#ifndef SMP_TP3_RESERVE_H
+#define SMP_TP3_RESERVE_H
+#include <memory>
+#include "image.h"
+
+t_Image *emprunterImage(int h, int w);
+t_Image *emprunterImage(int h, int w, unsigned int backgroundColor);
+void rendreImage(t_Image *image);
+void viderReserve();
+
+// rend l'image à la réserve au lieu de la détruire
+struct t_RendreImage {
+    void operator()(t_Image *image) const { rendreImage(image); }
+};
+
+typedef std::unique_ptr<t_Image, t_RendreImage> t_ImageEmpruntee;
+#endif //SMP_TP3_RESERVE_H
@@ -0,0 +1,181 @@
+//
+// Histogramme et choix automatique du seuil (Otsu, triangle).
+//
+
+#include "outils.h"
+#include "instrumentation.h"
+#include "parallele.h"
+#include <cmath>
+#include <cstring>
+
+/*
+ * Histogramme en une lecture de l'image : chaque bande de lignes est comptée par
+ * un thread dans ses propres histogrammes, additionnés à la fin. Dans une bande,
+ * les pixels sont lus par huit et répartis sur quatre sous-histogrammes, pour
+ * que des pixels voisins de même niveau n'incrémentent pas le même compteur
+ * l'un après l'autre (chaque incrément attendrait le précédent).
+ */
+static void compterBande(const t_Image *image, const int y0, const int y1, uint64_t histo[256]) {
+    uint32_t partiels[4][256];
+    memset(partiels, 0, sizeof(partiels));
+    const int w = image->w;
+    // les compteurs 32 bits sont vidés avant de pouvoir déborder
+    const int lignesParVidage = w > 0 ? (int) ((1u << 30) / (unsigned int) w) + 1 : 1;
+    auto vider = [&]() {
+        for (int k = 0; k < 4; k++)
+            for (int v = 0; v < 256; v++)
+                histo[v] += partiels[k][v];
+        memset(partiels, 0, sizeof(partiels));
+    };
+    for (int i = y0; i < y1; i++) {
+        const t_Pixel *ligne = image->ligne(i);
+        int x = 0;
+        for (; x + 8 <= w; x += 8) {
+            uint64_t huit;
+            memcpy(&huit, ligne + x, 8);
+            partiels[0][huit & 0xFF]++;
+            partiels[1][(huit >> 8) & 0xFF]++;
+            partiels[2][(huit >> 16) & 0xFF]++;
+            partiels[3][(huit >> 24) & 0xFF]++;
+            partiels[0][(huit >> 32) & 0xFF]++;
+            partiels[1][(huit >> 40) & 0xFF]++;
+            partiels[2][(huit >> 48) & 0xFF]++;
+            partiels[3][huit >> 56]++;
+        }
+        for (; x < w; x++)
+            partiels[0][ligne[x]]++;
+        if ((i - y0 + 1) % lignesParVidage == 0)
+            vider();
+    }
+    vider();
+}
+
+/**
+ * @brief Histogramme des niveaux de gris d'une image.
+ *
+ * @param image Image lue.
+ * @param histo histo[v] reçoit le nombre de pixels de niveau v.
+ *
+ * @pre image != nullptr
+ */
+void histogramme(const t_Image *image, uint64_t histo[256]) {
+    INSTRUMENTER("histogramme");
+    COMPTER_PIXELS((size_t) image->w * image->h);
+    COMPTER_LECTURE((size_t) image->w * image->h);
+    memset(histo, 0, 256 * sizeof(uint64_t));
+    const std::vector<t_Bande> bandes = decouperBandes(image->h, 0, 0);
+    std::vector<uint64_t> partiels(bandes.size() * 256, 0);
+    executerTaches((int) bandes.size(), [&](const int b) {
+        compterBande(image, bandes[b].y0, bandes[b].y1, partiels.data() + (size_t) b * 256);
+    });
+    for (size_t b = 0; b < bandes.size(); b++)
+        for (int v = 0; v < 256; v++)
+            histo[v] += partiels[b * 256 + v];
+}
+
+/*
+ * Otsu : le seuil t sépare les niveaux [0, t] et [t + 1, 255] ; on retient celui
+ * qui maximise la variance inter-classes w0 w1 (m0 - m1)², calculée en un
+ * balayage à partir des sommes cumulées.
+ */
+static unsigned int seuilOtsu(const uint64_t histo[256]) {
+    double total = 0, sommeTotale = 0;
+    for (int v = 0; v < 256; v++) {
+        total += (double) histo[v];
+        sommeTotale += (double) v * (double) histo[v];
+    }
+    double w0 = 0, somme0 = 0, meilleure = -1;
+    unsigned int seuil = 0;
+    for (int t = 0; t < 255; t++) {
+        w0 += (double) histo[t];
+        somme0 += (double) t * (double) histo[t];
+        const double w1 = total - w0;
+        if (w0 == 0 || w1 == 0)
+            continue;
+        const double ecart = somme0 / w0 - (sommeTotale - somme0) / w1;
+        const double variance = w0 * w1 * ecart * ecart;
+        if (variance > meilleure) {
+            meilleure = variance;
+            seuil = (unsigned int) t + 1;
+        }
+    }
+    return seuil;
+}
+
+/*
+ * Triangle (Zack) : droite tirée du pic de l'histogramme jusqu'au bout de sa plus
+ * longue queue ; le seuil est le niveau dont la barre est la plus éloignée de
+ * cette droite. Adapté aux histogrammes à un seul mode, où Otsu échoue.
+ */
+static unsigned int seuilTriangle(const uint64_t histo[256]) {
+    int premier = -1, dernier = -1, pic = 0;
+    for (int v = 0; v < 256; v++) {
+        if (histo[v] == 0)
+            continue;
+        if (premier < 0)
+            premier = v;
+        dernier = v;
+        if (histo[v] > histo[pic])
+            pic = v;
+    }
+    if (premier < 0 || premier == dernier)
+        return 0;
+    // bout de la queue : le niveau vide qui la suit, s'il existe
+    const bool queueGauche = pic - premier >= dernier - pic;
+    const int bout = queueGauche ? (premier > 0 ? premier - 1 : premier) : (dernier < 255 ? dernier + 1 : dernier);
+    const double hauteurPic = (double) histo[pic], hauteurBout = (double) histo[bout];
+    double meilleure = -1;
+    int t = bout;
+    const int pas = queueGauche ? 1 : -1;
+    for (int v = bout; v != pic; v += pas) {
+        // distance à la droite, au facteur de normalisation près (le même pour tous)
+        const double distance = std::fabs((hauteurPic - hauteurBout) * (v - bout) -
+                                          (double) (pic - bout) * ((double) histo[v] - hauteurBout));
+        if (distance > meilleure) {
+            meilleure = distance;
+            t = v;
+        }
+    }
+    // la queue forme la classe noire à gauche du pic, la classe blanche à droite
+    return queueGauche ? (unsigned int) t + 1 : (unsigned int) t;
+}
+
+/**
+ * @brief Seuil calculé à partir d'un histogramme, au sens de seuillage() : les
+ *        niveaux inférieurs au seuil renvoyé deviennent noirs.
+ *
+ * @param histo   Histogramme (voir histogramme()).
+ * @param methode SEUIL_OTSU ou SEUIL_TRIANGLE.
+ *
+ * @return Seuil compris entre 0 et 255 ; 0 si l'image n'a qu'un niveau de gris.
+ */
+unsigned int seuilAutomatique(const uint64_t histo[256], const t_MethodeSeuil methode) {
+    switch (methode) {
+        case SEUIL_TRIANGLE:
+            return seuilTriangle(histo);
+        case SEUIL_OTSU:
+        default:
+            return seuilOtsu(histo);
+    }
+}
+
+/**
+ * @brief Seuillage d'une image à un seuil calculé sur son propre histogramme.
+ *
+ * L'image est lue deux fois : une pour l'histogramme, une pour le seuillage.
+ *
+ * @param image   Image seuillée sur place.
+ * @param methode Calcul du seuil (voir seuilAutomatique()).
+ *
+ * @return Le seuil appliqué.
+ *
+ * @pre image != nullptr
+ */
+unsigned int seuillageAutomatique(t_Image *image, const t_MethodeSeuil methode) {
+    INSTRUMENTER("seuillageAutomatique");
+    uint64_t histo[256];
+    histogramme(image, histo);
+    const unsigned int s = seuilAutomatique(histo, methode);
+    seuillage(image, s);
+    return s;
+}
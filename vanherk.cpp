@@ -0,0 +1,189 @@
+//
+// Érosion et dilatation par des segments et des rectangles en un nombre constant
+// d'opérations par pixel (algorithme de van Herk / Gil-Werman).
+//
+
+#include "vanherk.h"
+#include "noyaux.h"
+#include "reserve.h"
+#include <algorithm>
+#include <cstring>
+
+/**
+ * @brief Indique si les cellules actives forment un rectangle plein.
+ *
+ * Les segments horizontaux et verticaux sont des rectangles de hauteur ou de
+ * largeur 1.
+ *
+ * @param decalages Cellules actives de l'élément structurant.
+ * @param fenetre   Reçoit l'étendue du rectangle lorsqu'il y en a un.
+ * @return vrai si les cellules actives couvrent exactement leur boîte englobante.
+ */
+bool estRectangle(const std::vector<t_Decalage> &decalages, t_Fenetre *fenetre) {
+    if (decalages.empty())
+        return false;
+
+    t_Fenetre f = {decalages[0].dx, decalages[0].dx, decalages[0].dy, decalages[0].dy};
+    for (const auto &d: decalages) {
+        f.dxMin = std::min(f.dxMin, d.dx);
+        f.dxMax = std::max(f.dxMax, d.dx);
+        f.dyMin = std::min(f.dyMin, d.dy);
+        f.dyMax = std::max(f.dyMax, d.dy);
+    }
+    // les décalages d'un élément sont distincts : il suffit de les compter
+    const size_t aire = (size_t) (f.dxMax - f.dxMin + 1) * (f.dyMax - f.dyMin + 1);
+    if (aire != decalages.size())
+        return false;
+
+    *fenetre = f;
+    return true;
+}
+
+/**
+ * @brief Coût estimé d'une érosion ou d'une dilatation par un rectangle.
+ *
+ * Le coût est exprimé en « passages directs » : le temps mis par morphologieLignes()
+ * pour combiner une cellule active sur toute l'image. Le passage horizontal, scalaire,
+ * coûte environ 40 passages directs, le passage vertical, vectoriel, environ 16
+ * (mesures sur une image de 1024 x 1024). Il est donc plus rentable d'utiliser le
+ * rectangle que les cellules une à une dès que leur nombre dépasse ce coût.
+ */
+int coutRectangle(const t_Fenetre &fenetre) {
+    int cout = 0;
+    if (fenetre.dxMax > fenetre.dxMin)
+        cout += 40;
+    if (fenetre.dyMax > fenetre.dyMin)
+        cout += 16;
+    return cout;
+}
+
+/**
+ * @brief Minimum ou maximum glissant d'une ligne sur la fenêtre [x + a, x + a + k - 1].
+ *
+ * La ligne est prolongée par l'élément neutre puis découpée en blocs de k pixels.
+ * Un préfixe (g) et un suffixe (h) cumulés sont calculés dans chaque bloc : toute
+ * fenêtre de k pixels est à cheval sur deux blocs au plus, et son extremum vaut
+ * op(h[x], g[x + k - 1]). Trois opérations par pixel, quel que soit k.
+ */
+template<bool estMaximum>
+static void extremumGlissant(const t_Pixel *src, t_Pixel *dst, const int w, const int a, const int k,
+                             std::vector<t_Pixel> &tampon) {
+    const t_Pixel neutre = estMaximum ? 0 : 255;
+    const auto op = [](const t_Pixel u, const t_Pixel v) { return estMaximum ? std::max(u, v) : std::min(u, v); };
+    const int n = (w + k - 1 + k - 1) / k * k;
+
+    // ligne prolongée : e[i] est le pixel x = i + a
+    tampon.assign(3 * (size_t) n, neutre);
+    t_Pixel *e = tampon.data();
+    t_Pixel *g = e + n;
+    t_Pixel *h = g + n;
+    const int x0 = std::max(0, a);
+    const int x1 = std::min(w, n + a);
+    if (x0 < x1)
+        memcpy(e + (x0 - a), src + x0, x1 - x0);
+
+    for (int debut = 0; debut < n; debut += k) {
+        g[debut] = e[debut];
+        for (int i = debut + 1; i < debut + k; i++)
+            g[i] = op(g[i - 1], e[i]);
+        h[debut + k - 1] = e[debut + k - 1];
+        for (int i = debut + k - 2; i >= debut; i--)
+            h[i] = op(h[i + 1], e[i]);
+    }
+
+    memcpy(dst, h, w);
+    (estMaximum ? noyaux().maxLigne : noyaux().minLigne)(dst, g + k - 1, w);
+}
+
+/**
+ * @brief Minimum ou maximum de @p imgIn sur un rectangle de décalages.
+ *
+ * Le rectangle est séparable : un passage horizontal (extremumGlissant sur chaque
+ * ligne) puis un passage vertical. Le passage vertical applique le même schéma de
+ * blocs aux lignes entières, combinées par les noyaux vectoriels (noyaux.h).
+ * Les pixels hors de l'image sont ignorés.
+ *
+ * @param imgIn      Image d'entrée.
+ * @param extremum   Reçoit l'extremum de chaque pixel ; réallouée aux dimensions de @p imgIn.
+ * @param fenetre    Étendue du rectangle.
+ * @param estMaximum vrai pour le maximum, faux pour le minimum.
+ *
+ * @pre imgIn != extremum
+ */
+void extremumRectangle(const t_Image *imgIn, t_Image *extremum, const t_Fenetre &fenetre, const bool estMaximum) {
+    const int w = imgIn->w;
+    const int h = imgIn->h;
+    const int kx = fenetre.dxMax - fenetre.dxMin + 1;
+    const int ky = fenetre.dyMax - fenetre.dyMin + 1;
+    const t_Pixel neutre = estMaximum ? 0 : 255;
+    const auto combiner = estMaximum ? noyaux().maxLigne : noyaux().minLigne;
+    const bool verticalInutile = ky == 1 && fenetre.dyMin == 0;
+
+    // passage horizontal, directement dans extremum s'il n'y a pas de passage vertical
+    t_ImageEmpruntee horizontal(verticalInutile ? nullptr : emprunterImage(h, w));
+    t_Image *passe = verticalInutile ? extremum : horizontal.get();
+    std::vector<t_Pixel> tampon;
+    passe->allouer(h, w);
+    for (int y = 0; y < h; y++) {
+        t_Pixel *dst = passe->ligne(y);
+        if (kx == 1 && fenetre.dxMin == 0)
+            memcpy(dst, imgIn->ligne(y), w);
+        else if (estMaximum)
+            extremumGlissant<true>(imgIn->ligne(y), dst, w, fenetre.dxMin, kx, tampon);
+        else
+            extremumGlissant<false>(imgIn->ligne(y), dst, w, fenetre.dxMin, kx, tampon);
+    }
+    if (verticalInutile)
+        return;
+
+    // passage vertical : la ligne i des tampons correspond à la ligne y = i + dyMin
+    const int n = (h + ky - 1 + ky - 1) / ky * ky;
+    const std::vector<t_Pixel> ligneNeutre(w, neutre);
+    const auto source = [&](const int i) {
+        const int y = i + fenetre.dyMin;
+        return (y >= 0 && y < h) ? horizontal->ligne(y) : ligneNeutre.data();
+    };
+    // chaque ligne des tampons est entièrement écrite : pas d'initialisation
+    t_ImageEmpruntee prefixes(emprunterImage(n, w)), suffixes(emprunterImage(n, w));
+    for (int i = 0; i < n; i++) {
+        t_Pixel *gi = prefixes->ligne(i);
+        memcpy(gi, source(i), w);
+        if (i % ky != 0)
+            combiner(gi, prefixes->ligne(i - 1), w);
+    }
+    for (int i = n - 1; i >= 0; i--) {
+        t_Pixel *hi = suffixes->ligne(i);
+        memcpy(hi, source(i), w);
+        if (i % ky != ky - 1)
+            combiner(hi, suffixes->ligne(i + 1), w);
+    }
+    extremum->allouer(h, w);
+    for (int y = 0; y < h; y++) {
+        t_Pixel *dst = extremum->ligne(y);
+        memcpy(dst, suffixes->ligne(y), w);
+        combiner(dst, prefixes->ligne(y + ky - 1), w);
+    }
+}
+
+/**
+ * @brief Érosion ou dilatation par un rectangle (ou un segment) plein.
+ *
+ * Même résultat que dilatation() ou erosion() avec un élément structurant dont
+ * les cellules actives forment @p fenetre, mais en un nombre d'opérations par
+ * pixel indépendant de la taille du rectangle.
+ *
+ * @param imgIn      Image d'entrée (non modifiée).
+ * @param imgOut     Image de sortie, de mêmes dimensions ; seuls les pixels
+ *                   dilatés (ou érodés) reçoivent @p fillColor.
+ * @param fenetre    Étendue du rectangle de décalages.
+ * @param estErosion vrai pour une érosion, faux pour une dilatation.
+ * @param fillColor  Couleur des pixels retenus (0 à 255).
+ */
+void morphologieRectangle(const t_Image *imgIn, t_Image *imgOut, const t_Fenetre &fenetre, const bool estErosion,
+                          const unsigned int fillColor) {
+    t_ImageEmpruntee extremum(emprunterImage(imgIn->h, imgIn->w));
+    extremumRectangle(imgIn, extremum.get(), fenetre, estErosion);
+
+    for (int y = 0; y < imgIn->h; y++)
+        noyaux().remplirSiNul(imgOut->ligne(y), extremum->ligne(y), imgIn->w, (t_Pixel) fillColor);
+}
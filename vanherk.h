@@ -0,0 +1,23 @@
+//
+// Érosion et dilatation par des segments et des rectangles en un nombre constant
+// d'opérations par pixel (algorithme de van Herk / Gil-Werman).
+//
+
+#ifndef SMP_TP3_VANHERK_H
+#define SMP_TP3_VANHERK_H
+#include <vector>
+#include "image.h"
+#include "outils.h"
+
+// rectangle de décalages [dxMin, dxMax] x [dyMin, dyMax] dont toutes les cellules sont actives
+typedef struct {
+    int dxMin, dxMax;
+    int dyMin, dyMax;
+} t_Fenetre;
+
+int coutRectangle(const t_Fenetre &fenetre);
+bool estRectangle(const std::vector<t_Decalage> &decalages, t_Fenetre *fenetre);
+void extremumRectangle(const t_Image *imgIn, t_Image *extremum, const t_Fenetre &fenetre, bool estMaximum);
+void morphologieRectangle(const t_Image *imgIn, t_Image *imgOut, const t_Fenetre &fenetre, bool estErosion,
+                          unsigned int fillColor);
+#endif //SMP_TP3_VANHERK_H